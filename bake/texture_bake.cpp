@@ -0,0 +1,246 @@
+#include "chunk.hpp"
+#include "xe_texture_file.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <vector>
+#include <string>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+
+using namespace app;
+using xe::TextureFile;
+
+// Bakes the block textures, in the order Chunk numbers them, into a single
+// texture file with every mip level built ahead of time and BC1 encoded, so
+// the game uploads them as they are. Mips are averaged in linear space, the
+// same as the blits done at load time otherwise. Pass --rgba to leave the
+// pixels uncompressed.
+
+static constexpr const char* DEFAULT_OUTPUT = "res/image/blocks.xtex";
+
+struct Layer {
+  uint32_t width;
+  uint32_t height;
+  std::vector<float> pixels; // linear RGBA
+};
+
+static float toLinear(unsigned char value) {
+  float c = value / 255.f;
+  return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static unsigned char toSrgb(float value) {
+  float c = std::clamp(value, 0.f, 1.f);
+  c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+  return static_cast<unsigned char>(c * 255.f + 0.5f);
+}
+
+static Layer loadLayer(const std::string& path) {
+  int width, height, channels;
+  stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+  if(!pixels) {
+    std::cerr << "failed to load texture: " << path << "\n";
+    std::exit(EXIT_FAILURE);
+  }
+  Layer layer{static_cast<uint32_t>(width), static_cast<uint32_t>(height), {}};
+  layer.pixels.resize(width * height * 4);
+  for(int i = 0; i < width * height * 4; i++) {
+    layer.pixels[i] = (i % 4 == 3) ? pixels[i] / 255.f : toLinear(pixels[i]);
+  }
+  stbi_image_free(pixels);
+  return layer;
+}
+
+// Box filter, an odd edge folds its last row or column into the one before.
+static Layer downsample(const Layer& layer) {
+  Layer next{std::max(layer.width / 2, 1u), std::max(layer.height / 2, 1u), {}};
+  next.pixels.resize(next.width * next.height * 4);
+  for(uint32_t y = 0; y < next.height; y++) {
+    for(uint32_t x = 0; x < next.width; x++) {
+      for(int c = 0; c < 4; c++) {
+        float total = 0.f;
+        for(uint32_t sy = 0; sy < 2; sy++) {
+          for(uint32_t sx = 0; sx < 2; sx++) {
+            uint32_t px = std::min(x * 2 + sx, layer.width - 1);
+            uint32_t py = std::min(y * 2 + sy, layer.height - 1);
+            total += layer.pixels[(px + py * layer.width) * 4 + c];
+          }
+        }
+        next.pixels[(x + y * next.width) * 4 + c] = total / 4.f;
+      }
+    }
+  }
+  return next;
+}
+
+static std::vector<unsigned char> toRgba8(const Layer& layer) {
+  std::vector<unsigned char> rgba(layer.pixels.size());
+  for(size_t i = 0; i < rgba.size(); i++) {
+    rgba[i] = (i % 4 == 3) ? static_cast<unsigned char>(std::clamp(layer.pixels[i], 0.f, 1.f) * 255.f + 0.5f) : toSrgb(layer.pixels[i]);
+  }
+  return rgba;
+}
+
+//
+//  BC1 ENCODING
+//
+
+static uint16_t to565(const std::array<int, 3>& color) {
+  return static_cast<uint16_t>(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+
+static std::array<int, 3> from565(uint16_t color) {
+  int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+  return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+}
+
+// Endpoints are the corners of the colour bounding box, pulled in slightly.
+// Blocks with any pixel under half alpha use the three colour mode, where
+// the fourth index is transparent black.
+static void encodeBlock(const unsigned char block[16][4], unsigned char out[8]) {
+  bool transparent = false;
+  std::array<int, 3> min{255, 255, 255}, max{0, 0, 0};
+  for(int i = 0; i < 16; i++) {
+    if(block[i][3] < 128) {
+      transparent = true;
+      continue;
+    }
+    for(int c = 0; c < 3; c++) {
+      min[c] = std::min(min[c], static_cast<int>(block[i][c]));
+      max[c] = std::max(max[c], static_cast<int>(block[i][c]));
+    }
+  }
+  if(min[0] > max[0]) {
+    min = max = {0, 0, 0};
+  }
+  for(int c = 0; c < 3; c++) {
+    int inset = (max[c] - min[c]) / 16;
+    min[c] += inset;
+    max[c] -= inset;
+  }
+
+  uint16_t color0 = to565(max);
+  uint16_t color1 = to565(min);
+  if(transparent ? color0 > color1 : color0 < color1) {
+    std::swap(color0, color1);
+  }
+
+  std::array<std::array<int, 3>, 4> palette{from565(color0), from565(color1)};
+  int colors = 4;
+  if(transparent || color0 == color1) {
+    for(int c = 0; c < 3; c++) {
+      palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+    }
+    colors = 3;
+  } else {
+    for(int c = 0; c < 3; c++) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+  }
+
+  uint32_t indices = 0;
+  for(int i = 0; i < 16; i++) {
+    uint32_t index = 3;
+    if(!transparent || block[i][3] >= 128) {
+      int best = INT32_MAX;
+      for(int p = 0; p < colors; p++) {
+        int distance = 0;
+        for(int c = 0; c < 3; c++) {
+          int d = block[i][c] - palette[p][c];
+          distance += d * d;
+        }
+        if(distance < best) {
+          best = distance;
+          index = p;
+        }
+      }
+    }
+    indices |= index << (i * 2);
+  }
+
+  out[0] = color0 & 0xff;
+  out[1] = color0 >> 8;
+  out[2] = color1 & 0xff;
+  out[3] = color1 >> 8;
+  for(int i = 0; i < 4; i++) {
+    out[4 + i] = (indices >> (i * 8)) & 0xff;
+  }
+}
+
+// Pixels past the edge of levels smaller than a block repeat the last row
+// and column.
+static std::vector<unsigned char> toBc1(const Layer& layer) {
+  std::vector<unsigned char> rgba = toRgba8(layer);
+  std::vector<unsigned char> bc1(TextureFile::imageSize(TextureFile::BC1, layer.width, layer.height));
+  size_t offset = 0;
+  for(uint32_t by = 0; by < layer.height; by += 4) {
+    for(uint32_t bx = 0; bx < layer.width; bx += 4) {
+      unsigned char block[16][4];
+      for(uint32_t i = 0; i < 16; i++) {
+        uint32_t x = std::min(bx + i % 4, layer.width - 1);
+        uint32_t y = std::min(by + i / 4, layer.height - 1);
+        memcpy(block[i], &rgba[(x + y * layer.width) * 4], 4);
+      }
+      encodeBlock(block, &bc1[offset]);
+      offset += 8;
+    }
+  }
+  return bc1;
+}
+
+int main(int argc, char** argv) {
+  TextureFile::Format format = TextureFile::BC1;
+  std::string output = DEFAULT_OUTPUT;
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "--rgba") == 0) {
+      format = TextureFile::RGBA8;
+    } else {
+      output = argv[i];
+    }
+  }
+
+  Chunk::load();
+  const auto &paths = Chunk::getTexturePaths();
+
+  std::vector<Layer> layers{};
+  for(const auto &path : paths) {
+    layers.push_back(loadLayer(path));
+    if(layers.back().width != layers[0].width || layers.back().height != layers[0].height) {
+      std::cerr << "texture differs in size from the first: " << path << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  TextureFile texture{};
+  texture.header.magic = TextureFile::MAGIC;
+  texture.header.version = TextureFile::VERSION;
+  texture.header.format = format;
+  texture.header.width = layers[0].width;
+  texture.header.height = layers[0].height;
+  texture.header.layers = static_cast<uint32_t>(layers.size());
+  texture.header.mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(layers[0].width, layers[0].height)))) + 1;
+  texture.header.sourceHash = TextureFile::hashSources(paths);
+  texture.sources = paths;
+
+  for(uint32_t level = 0; level < texture.header.mipLevels; level++) {
+    for(auto &layer : layers) {
+      if(level > 0) layer = downsample(layer);
+      std::vector<unsigned char> encoded = format == TextureFile::BC1 ? toBc1(layer) : toRgba8(layer);
+      texture.data.insert(texture.data.end(), encoded.begin(), encoded.end());
+    }
+  }
+
+  texture.write(output);
+  std::cout << "Baked " << layers.size() << " textures, " << texture.header.mipLevels << " mip levels, "
+            << texture.data.size() << " bytes to " << output << "\n";
+
+  Chunk::unload();
+  return EXIT_SUCCESS;
+}
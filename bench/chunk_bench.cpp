@@ -0,0 +1,158 @@
+#include "chunk_terrain.hpp"
+#include "chunk_mesher.hpp"
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace app;
+using namespace std::chrono;
+
+// Generates and meshes square grids of chunks for a few fixed seeds with no
+// window, GPU or audio, and writes the results as JSON so runs can be compared
+// against each other. Every measurement is the best of REPEATS runs.
+
+static constexpr uint32_t SEEDS[] = {12345, 1337, 42};
+static constexpr int GRID_SIZES[] = {4, 8};
+static constexpr int MAX_LOD = 3;
+static constexpr int REPEATS = 3;
+
+static constexpr double VOXELS = ChunkTerrain::CHUNK_SIZE.x * ChunkTerrain::CHUNK_SIZE.y * ChunkTerrain::CHUNK_SIZE.z;
+
+struct MeshResult {
+  int lod;
+  double seconds;
+  double quads;
+  double bytes;
+};
+
+struct CaseResult {
+  uint32_t seed;
+  int grid;
+  double generateSeconds;
+  std::vector<MeshResult> meshes;
+};
+
+template <typename F>
+static double best(F run) {
+  double seconds = 1e30;
+  for(int i = 0; i < REPEATS; i++) {
+    auto start = steady_clock::now();
+    run();
+    seconds = std::min(seconds, duration<double>(steady_clock::now() - start).count());
+  }
+  return seconds;
+}
+
+// Chunks are meshed inside a one chunk ring of extra generated chunks, so full
+// detail meshes always have their neighbours, the same as in game.
+static CaseResult runCase(uint32_t seed, int grid, const BlockTable& blocks) {
+  const int outer = grid + 2;
+  std::vector<std::vector<uint8_t>> chunks(outer * outer);
+  auto chunk = [&](int x, int z) -> std::vector<uint8_t>& { return chunks[(x + 1) + (z + 1) * outer]; };
+
+  CaseResult result{seed, grid, 0.0, {}};
+  result.generateSeconds = best([&]() {
+    for(int z = -1; z <= grid; z++) {
+      for(int x = -1; x <= grid; x++) {
+        ChunkTerrain::generate(seed, x, z, chunk(x, z));
+      }
+    }
+  }) * grid * grid / (outer * outer);
+
+  ChunkMesher::Volume volume{};
+  std::vector<unsigned char> vertexData{};
+  for(int lod = 0; lod <= MAX_LOD; lod++) {
+    size_t bytes = 0;
+    double seconds = best([&]() {
+      bytes = 0;
+      for(int z = 0; z < grid; z++) {
+        for(int x = 0; x < grid; x++) {
+          if(lod == 0) {
+            ChunkMesher::fill(chunk(x, z), volume);
+            ChunkMesher::fillBorder(&chunk(x - 1, z), -1, 0, volume);
+            ChunkMesher::fillBorder(&chunk(x + 1, z), 1, 0, volume);
+            ChunkMesher::fillBorder(&chunk(x, z - 1), 0, -1, volume);
+            ChunkMesher::fillBorder(&chunk(x, z + 1), 0, 1, volume);
+          } else {
+            ChunkMesher::downsample(chunk(x, z), lod, volume);
+          }
+          ChunkMesher::mesh(volume, 1 << lod, blocks, vertexData);
+          bytes += vertexData.size();
+        }
+      }
+    });
+    double count = grid * grid;
+    result.meshes.push_back({lod, seconds, bytes / (ChunkMesher::VERTEX_SIZE * 6.0) / count, bytes / count});
+  }
+  return result;
+}
+
+static void writeJson(const std::string& path, const std::vector<CaseResult>& results) {
+  std::ofstream file{path};
+  if(!file.is_open()) {
+    std::cerr << "failed to open " << path << "\n";
+    std::exit(EXIT_FAILURE);
+  }
+
+  file << std::fixed << std::setprecision(3);
+  file << "{\n  \"chunk_size\": [" << ChunkTerrain::CHUNK_SIZE.x << ", " << ChunkTerrain::CHUNK_SIZE.y << ", " << ChunkTerrain::CHUNK_SIZE.z << "],\n";
+  file << "  \"cases\": [";
+  for(size_t i = 0; i < results.size(); i++) {
+    const CaseResult& r = results[i];
+    const double count = r.grid * r.grid;
+    file << (i > 0 ? "," : "") << "\n    {\"seed\": " << r.seed << ", \"grid\": " << r.grid << ",\n";
+    file << "     \"generate\": {\"chunks_per_sec\": " << count / r.generateSeconds
+         << ", \"ns_per_voxel\": " << r.generateSeconds * 1e9 / (count * VOXELS) << "},\n";
+    file << "     \"mesh\": [";
+    for(size_t m = 0; m < r.meshes.size(); m++) {
+      const MeshResult& mesh = r.meshes[m];
+      file << (m > 0 ? "," : "") << "\n       {\"lod\": " << mesh.lod
+           << ", \"chunks_per_sec\": " << count / mesh.seconds
+           << ", \"quads_per_chunk\": " << mesh.quads
+           << ", \"vertex_bytes_per_chunk\": " << mesh.bytes
+           << ", \"ns_per_voxel\": " << mesh.seconds * 1e9 / (count * VOXELS) << "}";
+    }
+    file << "\n     ]}";
+  }
+  file << "\n  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+  const std::string output = argc > 1 ? argv[1] : "bench.json";
+
+  // Texture ids only end up in the vertex data, any distinct values will do.
+  BlockTable blocks{};
+  for(int block = 0; block < 256; block++) {
+    for(int face = 0; face < 6; face++) {
+      blocks[block].textures[face] = block * 6 + face;
+    }
+  }
+
+  std::vector<CaseResult> results{};
+  std::cout << std::fixed << std::setprecision(2);
+  for(const auto seed : SEEDS) {
+    for(const auto grid : GRID_SIZES) {
+      CaseResult r = runCase(seed, grid, blocks);
+      const double count = grid * grid;
+      std::cout << "seed " << seed << " grid " << grid << "x" << grid
+                << ": generate " << count / r.generateSeconds << " chunks/s, "
+                << r.generateSeconds * 1e9 / (count * VOXELS) << " ns/voxel\n";
+      for(const auto &mesh : r.meshes) {
+        std::cout << "  mesh lod " << mesh.lod << ": " << count / mesh.seconds << " chunks/s, "
+                  << mesh.quads << " quads/chunk, " << mesh.bytes << " bytes/chunk, "
+                  << mesh.seconds * 1e9 / (count * VOXELS) << " ns/voxel\n";
+      }
+      results.push_back(r);
+    }
+  }
+
+  writeJson(output, results);
+  std::cout << "Results written to " << output << "\n";
+  return EXIT_SUCCESS;
+}
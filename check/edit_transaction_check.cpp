@@ -0,0 +1,142 @@
+#include "chunk.hpp"
+#include "edit_transaction.hpp"
+
+#include <set>
+#include <vector>
+#include <utility>
+#include <string>
+#include <iostream>
+#include <cstdlib>
+
+using namespace app;
+
+// Applies edits across the corner where four chunks meet and checks every
+// block they could have written, plus which chunks were remeshed. Runs on the
+// core alone, with no window, GPU or region files.
+
+static constexpr uint32_t SEED = 12345;
+static constexpr int GRID_MIN = -2;
+static constexpr int GRID_MAX = 2;
+
+static int failures = 0;
+
+static void expect(bool condition, const std::string& message) {
+  if(condition) return;
+  std::cerr << "FAILED: " << message << "\n";
+  failures++;
+}
+
+static std::string at(int x, int y, int z) {
+  return "(" + std::to_string(x) + ", " + std::to_string(y) + ", " + std::to_string(z) + ")";
+}
+
+// Generates every chunk of the grid and meshes all but its outer ring, so each
+// meshed chunk has its neighbours, then takes the meshes so that only chunks
+// remeshed afterwards have a new one waiting.
+static void loadGrid() {
+  for(int z = GRID_MIN; z <= GRID_MAX; z++) {
+    for(int x = GRID_MIN; x <= GRID_MAX; x++) {
+      Chunk::generate(Chunk::newChunk(x, z, SEED));
+    }
+  }
+  std::vector<unsigned char> data{};
+  for(int z = GRID_MIN + 1; z < GRID_MAX; z++) {
+    for(int x = GRID_MIN + 1; x < GRID_MAX; x++) {
+      Chunk* chunk = Chunk::getChunk(x, z);
+      Chunk::createMesh(chunk);
+      expect(chunk->takeMesh(data), "chunk " + std::to_string(x) + ", " + std::to_string(z) + " did not mesh");
+    }
+  }
+}
+
+static std::set<std::pair<int, int>> takeRemeshed() {
+  std::set<std::pair<int, int>> remeshed{};
+  std::vector<unsigned char> data{};
+  for(int z = GRID_MIN; z <= GRID_MAX; z++) {
+    for(int x = GRID_MIN; x <= GRID_MAX; x++) {
+      if(Chunk::getChunk(x, z)->takeMesh(data)) remeshed.insert({x, z});
+    }
+  }
+  return remeshed;
+}
+
+int main() {
+  Chunk::load();
+  loadGrid();
+
+  // Block (0, y, 0) is the corner of chunk (0, 0), so the sphere and the paste
+  // both reach into the four chunks around it.
+  const glm::vec3 center{0.f, 40.f, 0.f};
+  const float radius = 2.5f;
+
+  EditTransaction::Template paste{};
+  paste.size = {4, 3, 4};
+  paste.blocks.assign(4 * 3 * 4, STONE);
+  paste.blocks[1 + 1 * 4 + 2 * 4 * 3] = static_cast<uint8_t>(INVALID);
+  const glm::ivec3 pasteOrigin{-2, 50, -2};
+
+  // The last column of chunk (0, 0) borders chunk (1, 0), which has to be
+  // remeshed too even though none of its blocks change.
+  const glm::ivec3 fillMin{Chunk::CHUNK_SIZE.x - 1, 60, 4};
+  const glm::ivec3 fillMax{Chunk::CHUNK_SIZE.x - 1, 61, 5};
+
+  const glm::ivec3 checkMin{-4, 36, -4};
+  const glm::ivec3 checkMax{Chunk::CHUNK_SIZE.x, 64, 8};
+  std::vector<uint8_t> before{};
+  for(int z = checkMin.z; z <= checkMax.z; z++) {
+    for(int y = checkMin.y; y <= checkMax.y; y++) {
+      for(int x = checkMin.x; x <= checkMax.x; x++) {
+        before.push_back(Chunk::getGlobalBlock(x, y, z));
+      }
+    }
+  }
+
+  EditTransaction transaction{};
+  transaction.sphere(center, radius, SNOW);
+  transaction.paste(pasteOrigin, paste);
+  transaction.fillBox(fillMin, fillMax, SAND);
+  transaction.fillBox({1000, 40, 1000}, {1001, 41, 1001}, SAND);
+  size_t skipped = transaction.commit();
+  expect(skipped == 1, "expected 1 skipped chunk, got " + std::to_string(skipped));
+
+  size_t index = 0;
+  for(int z = checkMin.z; z <= checkMax.z; z++) {
+    for(int y = checkMin.y; y <= checkMax.y; y++) {
+      for(int x = checkMin.x; x <= checkMax.x; x++) {
+        uint8_t expected = before[index++];
+        float dx = x + 0.5f - center.x;
+        float dy = y + 0.5f - center.y;
+        float dz = z + 0.5f - center.z;
+        if(dx * dx + dy * dy + dz * dz <= radius * radius) expected = SNOW;
+        glm::ivec3 local = glm::ivec3(x, y, z) - pasteOrigin;
+        if(local.x >= 0 && local.y >= 0 && local.z >= 0 && local.x < paste.size.x && local.y < paste.size.y && local.z < paste.size.z) {
+          uint8_t block = paste.blocks[local.x + local.y * paste.size.x + local.z * paste.size.x * paste.size.y];
+          if(block != static_cast<uint8_t>(INVALID)) expected = block;
+        }
+        if(x >= fillMin.x && x <= fillMax.x && y >= fillMin.y && y <= fillMax.y && z >= fillMin.z && z <= fillMax.z) {
+          expected = SAND;
+        }
+        uint8_t actual = Chunk::getGlobalBlock(x, y, z);
+        expect(actual == expected, "block at " + at(x, y, z) + " is " + std::to_string(actual) + ", expected " + std::to_string(expected));
+      }
+    }
+  }
+
+  const std::set<std::pair<int, int>> expectedRemeshed{{-1, -1}, {0, -1}, {-1, 0}, {0, 0}, {1, 0}};
+  const std::set<std::pair<int, int>> remeshed = takeRemeshed();
+  for(const auto &[x, z] : remeshed) {
+    expect(expectedRemeshed.count({x, z}) == 1, "chunk " + std::to_string(x) + ", " + std::to_string(z) + " was remeshed");
+  }
+  for(const auto &[x, z] : expectedRemeshed) {
+    expect(remeshed.count({x, z}) == 1, "chunk " + std::to_string(x) + ", " + std::to_string(z) + " was not remeshed");
+  }
+
+  Chunk::unload();
+
+  if(failures > 0) {
+    std::cerr << failures << " edit transaction checks failed\n";
+    return EXIT_FAILURE;
+  }
+  std::cout << "Edit transaction checks passed\n";
+  return EXIT_SUCCESS;
+}
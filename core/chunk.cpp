@@ -0,0 +1,370 @@
+#include "chunk.hpp"
+
+#include "xe_trace.hpp"
+
+#include <atomic>
+
+namespace app {
+
+//
+//  CHUNK CONSTRUCTORS AND DECONSTUCTORS
+//
+
+Chunk::Chunk(int32_t gridX, int32_t gridZ, uint32_t world_seed) 
+  : world_seed{world_seed},
+    chunk_seed{(world_seed * gridX) + (world_seed * gridZ) / 2},
+    gridX{gridX},
+    gridZ{gridZ} {
+  worker = nullptr;
+  generated = false;
+  modified = false;
+  meshLod = 0;
+  reload = false;
+  finished = false;
+  meshed = false;
+  chargedBytes = 0;
+}
+
+Chunk::~Chunk() {
+  resetThread();
+  ChunkCache::release(chargedBytes);
+  vertexData.clear();
+  cubes.clear();
+}
+
+//
+//  CHUNK CREATION, DELETION, AND RETREVAL
+//
+
+static std::map<std::pair<int32_t, int32_t>, Chunk*> chunks{};
+static std::atomic<uint32_t> generatedCount{0};
+static std::atomic<uint32_t> meshedCount{0};
+
+Chunk* Chunk::newChunk(int32_t gridX, int32_t gridZ, uint32_t world_seed) {
+  Chunk* chunk = new Chunk(gridX, gridZ, world_seed);
+  if(ChunkCache::take(gridX, gridZ, chunk->cubes, chunk->vertexData, chunk->modified)) {
+    chunk->generated = true;
+    chunk->finished = true;
+    chunk->reload = !chunk->vertexData.empty();
+  }
+  chunks[{gridX, gridZ}] = std::move(chunk);
+  return chunks[{gridX, gridZ}];
+}
+
+Chunk* Chunk::getChunk(int32_t gridX, int32_t gridZ) {
+  auto it = chunks.find({gridX, gridZ});
+  if(it != chunks.end()) {
+    return it->second;
+  }
+  return nullptr;
+}
+
+void Chunk::deleteChunk(int32_t gridX, int32_t gridZ) {
+  Chunk* chunk = getChunk(gridX, gridZ);
+  if(chunk == nullptr) return; // Chunk does not exist or is already deleted
+  chunk->resetThread();
+  ChunkCache::release(chunk->chargedBytes);
+  chunk->chargedBytes = 0;
+  if(chunk->generated) {
+    if(chunk->meshLod != 0) chunk->vertexData.clear();
+    ChunkCache::store(gridX, gridZ, chunk->cubes, chunk->vertexData, chunk->modified);
+  }
+  delete chunk;
+  chunks.erase({gridX, gridZ});
+}
+
+//
+//  CHUNK TEXTURE AND BLOCK LOADING
+//
+
+// Textures are only numbered here, in the order their paths were first used.
+// Loading the images themselves is left to ChunkModels.
+
+static BlockTable blocks{};
+static std::map<std::string, uint32_t> texturesIds{};
+static std::vector<std::string> texturePaths{};
+
+static uint32_t getTexture(const std::string& filePath) {
+  if(!texturesIds.count(filePath)) {
+    texturesIds[filePath] = static_cast<uint32_t>(texturePaths.size());
+    texturePaths.push_back(filePath);
+  }
+  return texturesIds[filePath];
+}
+
+const std::vector<std::string>& Chunk::getTexturePaths() {
+  return texturePaths;
+}
+
+void Chunk::load() {
+  blocks[DIRT] = {{getTexture(DIRT_TEXTURE), getTexture(DIRT_TEXTURE), getTexture(DIRT_TEXTURE), getTexture(DIRT_TEXTURE), getTexture(DIRT_TEXTURE), getTexture(DIRT_TEXTURE)}};
+  blocks[GRASS] = {{getTexture(GRASS_TEXTURE), getTexture(GRASS_TEXTURE), getTexture(GRASS_TOP_TEXTURE), getTexture(DIRT_TEXTURE), getTexture(GRASS_TEXTURE), getTexture(GRASS_TEXTURE)}};
+  blocks[FULL_GRASS] = {{getTexture(GRASS_TOP_TEXTURE), getTexture(GRASS_TOP_TEXTURE), getTexture(GRASS_TOP_TEXTURE), getTexture(GRASS_TOP_TEXTURE), getTexture(GRASS_TOP_TEXTURE), getTexture(GRASS_TOP_TEXTURE)}};
+  blocks[STONE] = {{getTexture(STONE_TEXTURE), getTexture(STONE_TEXTURE), getTexture(STONE_TEXTURE), getTexture(STONE_TEXTURE), getTexture(STONE_TEXTURE), getTexture(STONE_TEXTURE)}};
+  blocks[SNOW] = {{getTexture(SNOW_TEXTURE), getTexture(SNOW_TEXTURE), getTexture(SNOW_TEXTURE), getTexture(SNOW_TEXTURE), getTexture(SNOW_TEXTURE), getTexture(SNOW_TEXTURE)}};
+  blocks[SAND] = {{getTexture(SAND_TEXTURE), getTexture(SAND_TEXTURE), getTexture(SAND_TEXTURE), getTexture(SAND_TEXTURE), getTexture(SAND_TEXTURE), getTexture(SAND_TEXTURE)}};
+  blocks[WATER] = {{getTexture(WATER_TEXTURE), getTexture(WATER_TEXTURE), getTexture(WATER_TEXTURE), getTexture(WATER_TEXTURE), getTexture(WATER_TEXTURE), getTexture(WATER_TEXTURE)}};
+  blocks[SHRUB] = {{getTexture(SHRUB_TEXTURE), getTexture(SHRUB_TEXTURE), getTexture(SHRUB_TOP_TEXTURE), getTexture(DIRT_TEXTURE), getTexture(SHRUB_TEXTURE), getTexture(SHRUB_TEXTURE)}};
+  blocks[FULL_SHRUB] = {{getTexture(SHRUB_TOP_TEXTURE), getTexture(SHRUB_TOP_TEXTURE), getTexture(SHRUB_TOP_TEXTURE), getTexture(SHRUB_TOP_TEXTURE), getTexture(SHRUB_TOP_TEXTURE), getTexture(SHRUB_TOP_TEXTURE)}};
+}
+
+void Chunk::unload() {
+  for(const auto &[key, chunk]: chunks) {
+    chunk->save();
+    delete chunk;
+  }
+  chunks.clear();
+  texturesIds.clear();
+  texturePaths.clear();
+}
+
+//
+//  CHUNK MESH CREATION FOR BOTH SYNC AND ASYNC
+//
+
+void Chunk::createMeshAsync(Chunk* c, int lod) {
+  if(c == nullptr || !c->generated) return;
+  if(lod == 0 && (
+     !isGenerated(c->gridX-1, c->gridZ) ||
+     !isGenerated(c->gridX+1, c->gridZ) ||
+     !isGenerated(c->gridX, c->gridZ-1) ||
+     !isGenerated(c->gridX, c->gridZ+1))) {
+    return;
+  }
+  if(c->worker != nullptr && c->finished == false) return;
+  c->resetThread();
+  c->worker = new std::thread(createMesh, c, lod);
+}
+
+void Chunk::createMesh(Chunk* c, int lod) {
+  XE_TRACE_SCOPE("Chunk::createMesh");
+  if(c == nullptr) return;
+  if(lod == 0 && (
+     !isGenerated(c->gridX-1, c->gridZ) ||
+     !isGenerated(c->gridX+1, c->gridZ) ||
+     !isGenerated(c->gridX, c->gridZ-1) ||
+     !isGenerated(c->gridX, c->gridZ+1))) {
+    c->finished = true;
+    return;
+  }
+
+  // Full detail meshes see the facing edges of their neighbours, coarse
+  // meshes are closed off on every side, see ChunkMesher::downsample.
+  ChunkMesher::Volume volume{};
+  if(lod == 0) {
+    ChunkMesher::fill(c->cubes, volume);
+    const int neighbours[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    for(const auto &[dx, dz] : neighbours) {
+      Chunk* neighbour = getChunk(c->gridX + dx, c->gridZ + dz);
+      ChunkMesher::fillBorder(neighbour == nullptr ? nullptr : &neighbour->cubes, dx, dz, volume);
+    }
+  } else {
+    ChunkMesher::downsample(c->cubes, lod, volume);
+  }
+
+  ChunkMesher::mesh(volume, 1 << lod, blocks, c->vertexData);
+  c->meshLod = lod;
+  c->reload = true;
+  c->finished = false;
+  meshedCount++;
+}
+
+//
+//  CHUNK GENERATION FOR BOTH SYNC AND ASYNC
+//
+
+void Chunk::generateAsync(Chunk* c) {
+  if(c == nullptr || c->generated) return;
+  if(c->worker != nullptr && c->finished == false) return;
+  c->resetThread();
+  c->worker = new std::thread(generate, c);
+}
+
+void Chunk::generate(Chunk* c) {
+  XE_TRACE_SCOPE("Chunk::generate");
+  c->cubes.resize(CHUNK_SIZE.x*CHUNK_SIZE.y*CHUNK_SIZE.z);
+
+  if(Region::loadChunk(c->gridX, c->gridZ, c->cubes)) {
+    c->modified = false;
+    c->generated = true;
+    c->finished = true;
+    generatedCount++;
+    return;
+  }
+  
+  ChunkTerrain::generate(c->world_seed, c->gridX, c->gridZ, c->cubes);
+  c->modified = true;
+  c->generated = true;
+  c->finished = true;
+  generatedCount++;
+}
+
+Chunk::Counters Chunk::takeCounters() {
+  return {generatedCount.exchange(0), meshedCount.exchange(0)};
+}
+
+//
+//  BLOCK TEXTURES
+//
+
+uint32_t Chunk::getFaceTexture(uint8_t block, int face) {
+  return blocks[block].textures[face];
+}
+
+//
+//  CHUNK GETTERS AND SETTORS
+//
+
+// Hands over a mesh finished since the last call. The vertices are kept in the
+// chunk only when the chunk cache stores meshes and the mesh is full detail,
+// the only kind it caches, otherwise they are moved out. A kept copy is
+// charged to the cache budget until the chunk is unloaded.
+bool Chunk::takeMesh(std::vector<unsigned char>& data) {
+  if(!reload) return false;
+  resetThread();
+  ChunkCache::release(chargedBytes);
+  chargedBytes = 0;
+  if(ChunkCache::isMeshCaching() && meshLod == 0) {
+    data = vertexData;
+    chargedBytes = vertexData.size();
+    ChunkCache::charge(chargedBytes);
+  } else {
+    data = std::move(vertexData);
+    vertexData.clear();
+  }
+  reload = false;
+  meshed = true;
+  return true;
+}
+
+uint8_t Chunk::getBlock(int32_t x, int32_t y, int32_t z) {
+  if(y >= CHUNK_SIZE.y) return AIR;
+  if(y < 0) return INVALID;
+  int chunkX = gridX;
+  int chunkZ = gridZ;
+  if(x < 0) {
+    chunkX--;
+  } else if(x > CHUNK_SIZE.x-1) {
+    chunkX++;
+  }
+  if(z < 0) {
+    chunkZ--;
+  } else if(z > CHUNK_SIZE.z-1) {
+    chunkZ++;
+  }
+  x = (x+CHUNK_SIZE.x)%CHUNK_SIZE.x;
+  z = (z+CHUNK_SIZE.z)%CHUNK_SIZE.z;
+  if(chunkX == gridX && chunkZ == gridZ) {
+    int index = x + (y * CHUNK_SIZE.x) + (z * CHUNK_SIZE.x * CHUNK_SIZE.y);
+    return cubes[index];
+  } else {
+    Chunk* chunk = getChunk(chunkX, chunkZ);
+    if(chunk == NULL) {
+      return INVALID;
+    } else {
+       int index = x + (y * CHUNK_SIZE.x) + (z * CHUNK_SIZE.x * CHUNK_SIZE.y);
+      return chunk->cubes[index];
+    }
+  }
+}
+
+void Chunk::setBlock(int32_t x, int32_t y, int32_t z, uint8_t block) {
+  if(x < 0 || x >= CHUNK_SIZE.x) return;
+  if(y < 0 || y >= CHUNK_SIZE.y) return;
+  if(z < 0 || z >= CHUNK_SIZE.z) return;
+  int index = x + (y * CHUNK_SIZE.x) + (z * CHUNK_SIZE.x * CHUNK_SIZE.y);
+  cubes[index] = block;
+  modified = true;
+}
+
+uint8_t Chunk::getGlobalBlock(int32_t x, int32_t y, int32_t z) {
+  if(y >= CHUNK_SIZE.y) return AIR;
+  if(y < 0) return INVALID;
+  int gridX = ChunkTerrain::floorDiv(x, CHUNK_SIZE.x);
+  int gridZ = ChunkTerrain::floorDiv(z, CHUNK_SIZE.z);
+  Chunk* chunk = getChunk(gridX, gridZ);
+  if(chunk == nullptr) return INVALID;
+  int localX = x - gridX * CHUNK_SIZE.x;
+  int localZ = z - gridZ * CHUNK_SIZE.z;
+  return chunk->getBlock(localX, y, localZ);
+}
+
+void Chunk::setGlobalBlock(int32_t x, int32_t y, int32_t z, uint8_t block) {
+  if(y < 0 || y >= CHUNK_SIZE.y) return;
+  int gridX = ChunkTerrain::floorDiv(x, CHUNK_SIZE.x);
+  int gridZ = ChunkTerrain::floorDiv(z, CHUNK_SIZE.z);
+  Chunk* chunk = getChunk(gridX, gridZ);
+  if(chunk == nullptr) return;
+  int localX = x - gridX * CHUNK_SIZE.x;
+  int localZ = z - gridZ * CHUNK_SIZE.z;
+  chunk->setBlock(localX, y, localZ, block);
+}
+
+// Writes a block and rebuilds the mesh of its chunk right away on the calling
+// thread, along with any neighbour whose mesh shares the edited face, so the
+// change shows up on the next frame instead of waiting behind the mesh workers.
+bool Chunk::editBlock(int32_t x, int32_t y, int32_t z, uint8_t block) {
+  if(y < 0 || y >= CHUNK_SIZE.y) return false;
+  int gridX = ChunkTerrain::floorDiv(x, CHUNK_SIZE.x);
+  int gridZ = ChunkTerrain::floorDiv(z, CHUNK_SIZE.z);
+  Chunk* chunk = getChunk(gridX, gridZ);
+  if(chunk == nullptr || !chunk->generated) return false;
+  int localX = x - gridX * CHUNK_SIZE.x;
+  int localZ = z - gridZ * CHUNK_SIZE.z;
+
+  chunk->resetThread();
+  int index = localX + (y * CHUNK_SIZE.x) + (localZ * CHUNK_SIZE.x * CHUNK_SIZE.y);
+  if(chunk->cubes[index] == block) return false;
+  chunk->setBlock(localX, y, localZ, block);
+
+  remesh(gridX, gridZ);
+  if(localX == 0) remesh(gridX - 1, gridZ);
+  if(localX == CHUNK_SIZE.x - 1) remesh(gridX + 1, gridZ);
+  if(localZ == 0) remesh(gridX, gridZ - 1);
+  if(localZ == CHUNK_SIZE.z - 1) remesh(gridX, gridZ + 1);
+  return true;
+}
+
+// Chunks that were never meshed are left for the mesh workers. Unloaded chunks
+// only lose their cached mesh, since it was built against the old neighbour.
+void Chunk::remesh(int32_t gridX, int32_t gridZ) {
+  Chunk* chunk = getChunk(gridX, gridZ);
+  if(chunk == nullptr) {
+    ChunkCache::dropMesh(gridX, gridZ);
+    return;
+  }
+  if(!chunk->generated) return;
+  chunk->resetThread();
+  if(!chunk->meshed && !chunk->reload) return;
+  createMesh(chunk, chunk->meshLod);
+}
+
+bool Chunk::isGenerated(int32_t gridX, int32_t gridZ) {
+  Chunk* chunk = Chunk::getChunk(gridX, gridZ);
+  if(chunk == nullptr) return false;
+  return chunk->generated;
+}
+
+bool Chunk::isMeshed(int32_t gridX, int32_t gridZ) {
+  Chunk* chunk = Chunk::getChunk(gridX, gridZ);
+  if(chunk == nullptr) return false;
+  return chunk->meshed;
+}
+
+void Chunk::resetThread() {
+  if(worker != nullptr && worker->joinable()) {
+    worker->join();
+    finished = false;
+    delete worker;
+    worker = nullptr;
+  }
+}
+
+void Chunk::save() {
+  resetThread();
+  if(!generated || !modified) return;
+  Region::saveChunk(gridX, gridZ, cubes);
+  modified = false;
+}
+
+}
\ No newline at end of file
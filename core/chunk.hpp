@@ -1,33 +1,22 @@
 #pragma once
 
-#include "xe_model.hpp"
-#include "xe_engine.hpp"
-#include "xe_image.hpp"
-
 #include "chunk_noise.hpp"
+#include "chunk_terrain.hpp"
+#include "chunk_mesher.hpp"
+#include "region.hpp"
+#include "chunk_cache.hpp"
 
 #include <glm/common.hpp>
 #include <glm/fwd.hpp>
 #include <vector>
 #include <thread>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <map>
 #include <algorithm>
 #include <cstdlib>
 
-#define INVALID             -1
-#define AIR                 0
-#define DIRT                1
-#define GRASS               2
-#define FULL_GRASS          3
-#define STONE               4
-#define SNOW                5
-#define SAND                6
-#define WATER               7
-#define SHRUB               8
-#define FULL_SHRUB          9
-
 #define DIRT_TEXTURE        "res/image/dirt.png"
 #define GRASS_TEXTURE       "res/image/grass.png"
 #define GRASS_TOP_TEXTURE   "res/image/grass_top.png"
@@ -40,36 +29,47 @@
 
 namespace app {
 
-struct Block {
-  uint32_t textures[6];
-};
-
 class Chunk {
 
   public:
 
-    static constexpr int WATER_LEVEL = 20;
-    static constexpr glm::ivec3 CHUNK_SIZE{32, 256, 32};
+    static constexpr int WATER_LEVEL = ChunkTerrain::WATER_LEVEL;
+    static constexpr glm::ivec3 CHUNK_SIZE = ChunkTerrain::CHUNK_SIZE;
 
     static void load();
     static void unload();
-    static std::vector<xe::Image*>& getTextures();
+    static const std::vector<std::string>& getTexturePaths();
 
     static Chunk* newChunk(int32_t gridX, int32_t gridZ, uint32_t world_seed);
     static Chunk* getChunk(int32_t gridX, int32_t gridZ);
     static void deleteChunk(int32_t gridX, int32_t gridZ);
 
-    static void createMesh(Chunk* c);
-    static void createMeshAsync(Chunk* c);
+    static constexpr int MAX_LOD = 3;
+
+    static void createMesh(Chunk* c, int lod = 0);
+    static void createMeshAsync(Chunk* c, int lod = 0);
 
     static void generate(Chunk* c);
     static void generateAsync(Chunk* c);
 
-    xe::Model* getMesh();
+    static uint32_t getFaceTexture(uint8_t block, int face);
+
+    // Work finished by the chunk workers since the last call.
+    struct Counters {
+      uint32_t generated;
+      uint32_t meshed;
+    };
+    static Counters takeCounters();
+
+    bool takeMesh(std::vector<unsigned char>& data);
+    int getLod() const { return meshLod; }
+    bool isGenerated() const { return generated; }
     uint8_t getBlock(int32_t x, int32_t y, int32_t z);
     void setBlock(int32_t x, int32_t y, int32_t z, uint8_t block);
     static uint8_t getGlobalBlock(int32_t x, int32_t y, int32_t z);
     static void setGlobalBlock(int32_t x, int32_t y, int32_t z, uint8_t block);
+    static bool editBlock(int32_t x, int32_t y, int32_t z, uint8_t block);
+    static void remesh(int32_t gridX, int32_t gridZ);
 
     static bool isGenerated(int32_t gridX, int32_t gridZ);
     static bool isMeshed(int32_t gridX, int32_t gridZ);
@@ -83,15 +83,22 @@ class Chunk {
     ~Chunk();
 
     void resetThread();
+    void save();
 
     bool generated;
+    bool modified;
     bool reload;
     bool finished;
+    bool meshed;
+    // Written by the mesh worker and read by World while it runs.
+    std::atomic<int> meshLod;
 
-    xe::Model* chunkMesh;
-    xe::Model::Data vertexData;
+    std::vector<unsigned char> vertexData{};
+    size_t chargedBytes;
     std::vector<uint8_t> cubes{};
     std::thread* worker;
+
+    friend class EditTransaction;
     
 };
 
@@ -0,0 +1,130 @@
+#include "chunk_cache.hpp"
+
+#include <list>
+#include <algorithm>
+
+namespace app {
+
+//
+//  CACHE STATE
+//
+
+struct CacheEntry {
+  int32_t gridX, gridZ;
+  std::vector<uint8_t> cubes;
+  std::vector<unsigned char> mesh;
+  bool modified;
+
+  size_t bytes() const { return cubes.size() + mesh.size(); }
+};
+
+static std::list<CacheEntry> entries{};
+static std::map<std::pair<int32_t, int32_t>, std::list<CacheEntry>::iterator> lookup{};
+static size_t budget = ChunkCache::DEFAULT_BUDGET_MB * 1024 * 1024;
+static size_t used = 0;
+static size_t resident = 0;
+static bool meshCaching = false;
+
+//
+//  CACHE CONFIGURATION
+//
+
+void ChunkCache::setBudget(size_t megabytes) {
+  budget = megabytes * 1024 * 1024;
+  evict(budget);
+}
+
+void ChunkCache::setMeshCaching(bool enabled) {
+  meshCaching = enabled;
+  if(enabled) return;
+  for(auto &entry : entries) {
+    used -= entry.mesh.size();
+    entry.mesh.clear();
+    entry.mesh.shrink_to_fit();
+  }
+}
+
+bool ChunkCache::isMeshCaching() {
+  return meshCaching;
+}
+
+size_t ChunkCache::size() {
+  return used + resident;
+}
+
+//
+//  CACHE STORAGE AND RETREVAL
+//
+
+void ChunkCache::store(int32_t gridX, int32_t gridZ, std::vector<uint8_t>& cubes, std::vector<unsigned char>& mesh, bool modified) {
+  auto it = lookup.find({gridX, gridZ});
+  if(it != lookup.end()) {
+    used -= it->second->bytes();
+    entries.erase(it->second);
+    lookup.erase(it);
+  }
+
+  CacheEntry entry{gridX, gridZ, {}, {}, modified};
+  entry.cubes.swap(cubes);
+  if(meshCaching) entry.mesh.swap(mesh);
+
+  used += entry.bytes();
+  entries.push_front(std::move(entry));
+  lookup[{gridX, gridZ}] = entries.begin();
+
+  evict(budget);
+}
+
+bool ChunkCache::take(int32_t gridX, int32_t gridZ, std::vector<uint8_t>& cubes, std::vector<unsigned char>& mesh, bool& modified) {
+  auto it = lookup.find({gridX, gridZ});
+  if(it == lookup.end()) return false;
+  CacheEntry& entry = *it->second;
+  used -= entry.bytes();
+  cubes.swap(entry.cubes);
+  mesh.swap(entry.mesh);
+  modified = entry.modified;
+  entries.erase(it->second);
+  lookup.erase(it);
+  return true;
+}
+
+// A cached mesh is only valid while its neighbours still hold the voxels it was
+// built against, so edits next to a cached chunk have to throw its mesh away.
+void ChunkCache::dropMesh(int32_t gridX, int32_t gridZ) {
+  auto it = lookup.find({gridX, gridZ});
+  if(it == lookup.end()) return;
+  used -= it->second->mesh.size();
+  it->second->mesh.clear();
+  it->second->mesh.shrink_to_fit();
+}
+
+// Meshes loaded chunks keep on the CPU so they can be cached when unloaded
+// count against the budget too, and push unloaded chunks out to make room.
+void ChunkCache::charge(size_t bytes) {
+  resident += bytes;
+  evict(budget);
+}
+
+void ChunkCache::release(size_t bytes) {
+  resident -= std::min(bytes, resident);
+}
+
+void ChunkCache::clear() {
+  evict(0);
+}
+
+// Least recently unloaded chunks are dropped first. Chunks that were edited or
+// never persisted are written back to their region on the way out.
+void ChunkCache::evict(size_t limit) {
+  while(used + resident > limit && !entries.empty()) {
+    CacheEntry& entry = entries.back();
+    if(entry.modified) {
+      Region::saveChunk(entry.gridX, entry.gridZ, entry.cubes);
+    }
+    used -= entry.bytes();
+    lookup.erase({entry.gridX, entry.gridZ});
+    entries.pop_back();
+  }
+}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "region.hpp"
+
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+namespace app {
+
+class ChunkCache {
+
+  public:
+
+    static constexpr size_t DEFAULT_BUDGET_MB = 256;
+
+    static void setBudget(size_t megabytes);
+    static void setMeshCaching(bool enabled);
+    static bool isMeshCaching();
+
+    static void store(int32_t gridX, int32_t gridZ, std::vector<uint8_t>& cubes, std::vector<unsigned char>& mesh, bool modified);
+    static bool take(int32_t gridX, int32_t gridZ, std::vector<uint8_t>& cubes, std::vector<unsigned char>& mesh, bool& modified);
+    static void dropMesh(int32_t gridX, int32_t gridZ);
+    static void charge(size_t bytes);
+    static void release(size_t bytes);
+    static void clear();
+
+    static size_t size();
+
+  private:
+
+    static void evict(size_t limit);
+
+};
+
+}
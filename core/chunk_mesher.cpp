@@ -0,0 +1,273 @@
+#include "chunk_mesher.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace app {
+
+//
+//  MESHER VOLUMES
+//
+
+void ChunkMesher::Volume::reset(glm::ivec3 newSize, uint8_t border) {
+  size = newSize;
+  const int layer = (size.x + 2) * (size.y + 2);
+  blocks.assign(layer * (size.z + 2), border);
+  for(int z = -1; z <= size.z; z++) {
+    for(int x = -1; x <= size.x; x++) {
+      set(x, -1, z, static_cast<uint8_t>(INVALID));
+      set(x, size.y, z, AIR);
+    }
+  }
+}
+
+// Copies a full detail chunk into the inside of the volume. The border is
+// left as it was, see fillBorder.
+void ChunkMesher::fill(const std::vector<uint8_t>& cubes, Volume& volume) {
+  const glm::ivec3 size = ChunkTerrain::CHUNK_SIZE;
+  volume.reset(size, static_cast<uint8_t>(INVALID));
+  for(int z = 0; z < size.z; z++) {
+    for(int y = 0; y < size.y; y++) {
+      const uint8_t* row = cubes.data() + (y * size.x) + (z * size.x * size.y);
+      std::copy(row, row + size.x, volume.blocks.begin() + 1 + (y + 1) * (size.x + 2) + (z + 1) * (size.x + 2) * (size.y + 2));
+    }
+  }
+}
+
+// Copies the facing edge of the neighbour at dx, dz into the border. Without
+// a neighbour the border stays INVALID, the same as Chunk::getBlock returns.
+void ChunkMesher::fillBorder(const std::vector<uint8_t>* cubes, int dx, int dz, Volume& volume) {
+  if(cubes == nullptr || cubes->empty()) return;
+  const glm::ivec3 size = ChunkTerrain::CHUNK_SIZE;
+  auto index = [&](int x, int y, int z) { return x + (y * size.x) + (z * size.x * size.y); };
+  for(int y = 0; y < size.y; y++) {
+    if(dx != 0) {
+      const int from = dx < 0 ? size.x - 1 : 0;
+      const int to = dx < 0 ? -1 : size.x;
+      for(int z = 0; z < size.z; z++) {
+        volume.set(to, y, z, (*cubes)[index(from, y, z)]);
+      }
+    } else {
+      const int from = dz < 0 ? size.z - 1 : 0;
+      const int to = dz < 0 ? -1 : size.z;
+      for(int x = 0; x < size.x; x++) {
+        volume.set(x, y, to, (*cubes)[index(x, y, from)]);
+      }
+    }
+  }
+}
+
+// Shrinks the chunk by 2^lod on every axis. A coarse cell is solid when most of
+// the voxels it covers are, and takes the highest solid block in it so the
+// surface keeps its grass, sand or snow. Everything around the chunk is air,
+// which closes coarse meshes with walls that hide cracks against neighbours
+// meshed at a different level.
+void ChunkMesher::downsample(const std::vector<uint8_t>& cubes, int lod, Volume& volume) {
+  const glm::ivec3 full = ChunkTerrain::CHUNK_SIZE;
+  const int scale = 1 << lod;
+  const glm::ivec3 size = full / scale;
+  const int threshold = (scale * scale * scale + 1) / 2;
+  volume.reset(size, AIR);
+
+  for(int z = 0; z < size.z; z++) {
+    for(int x = 0; x < size.x; x++) {
+      for(int y = 0; y < size.y; y++) {
+        int solid = 0;
+        uint8_t top = AIR;
+        for(int dy = scale - 1; dy >= 0; dy--) {
+          for(int dz = 0; dz < scale; dz++) {
+            for(int dx = 0; dx < scale; dx++) {
+              int index = (x * scale + dx) + ((y * scale + dy) * full.x) + ((z * scale + dz) * full.x * full.y);
+              uint8_t block = cubes[index];
+              if(block == AIR) continue;
+              if(top == AIR) top = block;
+              solid++;
+            }
+          }
+        }
+        if(solid >= threshold) {
+          volume.set(x, y, z, top);
+        }
+      }
+    }
+  }
+}
+
+//
+//  GREEDY MESHING
+//
+
+struct FMask {
+  int block;
+  int normal;
+};
+
+static bool CompareMask(FMask a, FMask b){
+  if(a.block == INVALID || b.block == INVALID) return false;
+  return a.block == b.block && a.normal == b.normal;
+}
+
+template <typename T>
+static void Write(std::vector<unsigned char>& data, T d) {
+  const size_t offset = data.size();
+  data.resize(offset + sizeof(T));
+  std::memcpy(data.data() + offset, &d, sizeof(T));
+}
+
+static void AddVertex(std::vector<unsigned char>& data, const BlockTable& blocks, glm::vec3 Pos, glm::vec3 Nor, FMask Mask, glm::vec3 AxisMask, float Uv[2]) {
+  Write<float>(data, Pos[0]);
+  Write<float>(data, Pos[1]);
+  Write<float>(data, Pos[2]);
+  Write<float>(data, Nor[0]);
+  Write<float>(data, Nor[1]);
+  Write<float>(data, Nor[2]);
+  Write<float>(data, Uv[0]);
+  Write<float>(data, Uv[1]);
+
+  int i = AxisMask[1]*2+AxisMask[2]*4+(Mask.normal<0?1:0);
+  Write<uint32_t>(data, blocks[static_cast<uint8_t>(Mask.block)].textures[i]);
+}
+
+static void CreateQuad(std::vector<unsigned char>& data, const BlockTable& blocks, FMask Mask, glm::vec3 AxisMask, glm::vec3 V1, glm::vec3 V2, glm::vec3 V3, glm::vec3 V4, uint32_t width, uint32_t height) {
+  const auto Normal = glm::vec3(AxisMask) * glm::vec3(Mask.normal);
+  const glm::vec3 verticies[4] = {V1, V2, V3, V4};
+
+  if(Mask.block == AIR || Mask.block == INVALID) return;
+
+  float uv[4][2];
+
+  if(AxisMask.x == 1) {
+    uv[0][0] = height; uv[0][1] = width;
+    uv[1][0] = height; uv[1][1] = 0;
+    uv[2][0] = 0; uv[2][1] = width;
+    uv[3][0] = 0; uv[3][1] = 0;
+  } else {
+    uv[0][0] = width; uv[0][1] = height;
+    uv[1][0] = 0; uv[1][1] = height;
+    uv[2][0] = width; uv[2][1] = 0;
+    uv[3][0] = 0; uv[3][1] = 0;
+  }
+
+  AddVertex(data, blocks, verticies[0], Normal, Mask, AxisMask, uv[0]);
+  AddVertex(data, blocks, verticies[2 - Mask.normal], Normal, Mask, AxisMask, uv[2 - Mask.normal]);
+  AddVertex(data, blocks, verticies[2 + Mask.normal], Normal, Mask, AxisMask, uv[2 + Mask.normal]);
+  AddVertex(data, blocks, verticies[3], Normal, Mask, AxisMask, uv[3]);
+  AddVertex(data, blocks, verticies[1 + Mask.normal], Normal, Mask, AxisMask, uv[1 + Mask.normal]);
+  AddVertex(data, blocks, verticies[1 - Mask.normal], Normal, Mask, AxisMask, uv[1 - Mask.normal]);
+
+}
+
+// Sweeps a plane through the volume along each axis, marks every face between
+// an opaque and an open block and merges matching faces into the largest
+// rectangles it can. Positions are scaled back up by scale for coarse meshes.
+void ChunkMesher::mesh(const Volume& volume, int scale, const BlockTable& blocks, std::vector<unsigned char>& vertexData) {
+  const glm::ivec3 size = volume.size;
+
+  vertexData.clear();
+  for (int Axis = 0; Axis < 3; ++Axis) {
+    const int Axis1 = (Axis + 1) % 3;
+    const int Axis2 = (Axis + 2) % 3;
+
+    const int MainAxisLimit = size[Axis];
+    const int Axis1Limit = size[Axis1];
+    const int Axis2Limit = size[Axis2];
+
+    auto DeltaAxis1 = glm::vec3(0.f);
+    auto DeltaAxis2 = glm::vec3(0.f);
+
+    auto ChunkItr = glm::vec3(0.f);
+    auto AxisMask = glm::vec3(0.f);
+
+    AxisMask[Axis] = 1;
+
+    std::vector<FMask> Mask;
+    Mask.resize(Axis1Limit * Axis2Limit);
+
+    for (ChunkItr[Axis] = -1; ChunkItr[Axis] < MainAxisLimit;) {
+      int N = 0;
+
+      for (ChunkItr[Axis2] = 0; ChunkItr[Axis2] < Axis2Limit; ++ChunkItr[Axis2]) {
+        for (ChunkItr[Axis1] = 0; ChunkItr[Axis1] < Axis1Limit; ++ChunkItr[Axis1]) {
+          const auto CurrentBlock = volume.get(ChunkItr[0], ChunkItr[1], ChunkItr[2]);
+          const auto CompareBlock = volume.get(ChunkItr[0] + AxisMask[0], ChunkItr[1] + AxisMask[1] , ChunkItr[2] + AxisMask[2]);
+
+          const bool CurrentBlockOpaque = CurrentBlock != AIR && CurrentBlock != INVALID;
+          const bool CompareBlockOpaque = CompareBlock != AIR && CompareBlock != INVALID;
+
+          if (CurrentBlockOpaque == CompareBlockOpaque) {
+            Mask[N++] = FMask { INVALID, 0 };
+          } else  if (CurrentBlockOpaque) {
+            Mask[N++] = FMask { CurrentBlock, 1};
+          } else {
+            Mask[N++] = FMask { CompareBlock, -1};
+          }
+        }
+      }
+
+      ++ChunkItr[Axis];
+      N = 0;
+
+      for (int j = 0; j < Axis2Limit; ++j) {
+        for (int i = 0; i < Axis1Limit;) {
+          if(Mask[N].normal != 0) {
+            const auto CurrentMask = Mask[N];
+            ChunkItr[Axis1] = i;
+            ChunkItr[Axis2] = j;
+
+            int width;
+
+            for(width = 1; i + width < Axis1Limit && CompareMask(Mask[N + width], CurrentMask); ++width) {}
+
+            int height;
+            bool done = false;
+
+            for (height = 1; j + height < Axis2Limit; ++height) {
+              for(int k = 0; k < width; ++k) {
+                if(CompareMask(Mask[N + k + height * Axis1Limit], CurrentMask)) continue;
+
+                done = true;
+                break;
+              }
+
+              if(done) break;
+            }
+
+            DeltaAxis1[Axis1] = width;
+            DeltaAxis2[Axis2] = height;
+
+            CreateQuad(vertexData, blocks, CurrentMask, AxisMask,
+              ChunkItr * float(scale),
+              (ChunkItr + DeltaAxis1) * float(scale),
+              (ChunkItr + DeltaAxis2) * float(scale),
+              (ChunkItr + DeltaAxis1 + DeltaAxis2) * float(scale),
+              width * scale,
+              height * scale
+            );
+
+            DeltaAxis1 = glm::vec3(0.f);
+            DeltaAxis2 = glm::vec3(0.f);
+
+            for (int l = 0; l < height; ++l) {
+              for(int k = 0; k < width; ++k) {
+                Mask[N + k + l * Axis1Limit] = FMask { INVALID, 0 };
+              }
+            }
+
+            i += width;
+            N += width;
+
+          } else {
+
+            i++;
+            N++;
+
+          }
+
+        }
+      }
+    }
+
+  }
+}
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "chunk_terrain.hpp"
+
+#include <glm/common.hpp>
+#include <glm/fwd.hpp>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+namespace app {
+
+struct Block {
+  uint32_t textures[6];
+};
+
+using BlockTable = std::array<Block, 256>;
+
+// The greedy mesher on its own, with no dependency on the engine. Vertices are
+// written 36 bytes each: position, normal, uv and texture index.
+class ChunkMesher {
+
+  public:
+
+    static constexpr uint32_t VERTEX_SIZE = 36;
+
+    // Blocks of a chunk with a one block border on every side, so the mesher
+    // never has to look anything up outside of it. Below the chunk is INVALID
+    // and above it is AIR unless the border is filled in otherwise.
+    struct Volume {
+      glm::ivec3 size{0};
+      std::vector<uint8_t> blocks{};
+
+      void reset(glm::ivec3 size, uint8_t border);
+      uint8_t get(int x, int y, int z) const {
+        return blocks[(x + 1) + (y + 1) * (size.x + 2) + (z + 1) * (size.x + 2) * (size.y + 2)];
+      }
+      void set(int x, int y, int z, uint8_t block) {
+        blocks[(x + 1) + (y + 1) * (size.x + 2) + (z + 1) * (size.x + 2) * (size.y + 2)] = block;
+      }
+    };
+
+    static void fill(const std::vector<uint8_t>& cubes, Volume& volume);
+    static void fillBorder(const std::vector<uint8_t>* cubes, int dx, int dz, Volume& volume);
+    static void downsample(const std::vector<uint8_t>& cubes, int lod, Volume& volume);
+
+    static void mesh(const Volume& volume, int scale, const BlockTable& blocks, std::vector<unsigned char>& vertexData);
+
+};
+
+}
@@ -0,0 +1,83 @@
+#include "chunk_terrain.hpp"
+
+#include <algorithm>
+
+namespace app {
+
+//
+//  TERRAIN GENERATION
+//
+
+// Fills cubes with the natural terrain of the chunk at gridX, gridZ. The same
+// seed and grid position always give the same blocks.
+void ChunkTerrain::generate(uint32_t worldSeed, int32_t gridX, int32_t gridZ, std::vector<uint8_t>& cubes) {
+  cubes.assign(CHUNK_SIZE.x * CHUNK_SIZE.y * CHUNK_SIZE.z, AIR);
+
+  const PerlinNoise perlin{worldSeed};
+
+  for(int x = 0; x < CHUNK_SIZE.x; x++) {
+    for(int z = 0; z < CHUNK_SIZE.z; z++) {
+      double biome = columnBiome(perlin, gridX, gridZ, x, z);
+      int height = columnHeight(perlin, gridX, gridZ, x, z);
+      for(int y = 0; y < std::max(height, WATER_LEVEL); y++) {
+        uint8_t block = layerBlock(y, biome);
+        if(block != AIR) cubes[x + (y * CHUNK_SIZE.x) + (z * CHUNK_SIZE.x * CHUNK_SIZE.y)] = block;
+      }
+    }
+  }
+}
+
+//
+//  TERRAIN SHAPE FUNCTIONS
+//
+
+int32_t ChunkTerrain::floorDiv(int32_t a, int32_t b) {
+  int32_t d = a / b;
+  return (a % b != 0 && (a < 0) != (b < 0)) ? d - 1 : d;
+}
+
+double ChunkTerrain::columnBiome(const PerlinNoise& perlin, int32_t gridX, int32_t gridZ, int32_t x, int32_t z) {
+  return perlin.octave2D_01((( x + gridX * 13) * 0.0005), ((z + gridZ * 13) * 0.0005), 4) * 2;
+}
+
+int ChunkTerrain::columnHeight(const PerlinNoise& perlin, int32_t gridX, int32_t gridZ, int32_t x, int32_t z) {
+  double continent = perlin.octave2D_01((( x + gridX * CHUNK_SIZE.x) * 0.001), ((z + gridZ * CHUNK_SIZE.z) * 0.001), 4) * 10 - 5;
+  double noise = perlin.octave2D_01((( x + gridX * CHUNK_SIZE.x) * 0.01), ((z + gridZ * CHUNK_SIZE.z) * 0.01), 4);
+  return noise * 40 + continent;
+}
+
+uint8_t ChunkTerrain::layerBlock(int32_t y, double biome) {
+  int difference = y - WATER_LEVEL;
+  if (difference < 0) {
+    return WATER;
+  } else if(difference < 3) {
+    return SAND;
+  } else if(difference < 5) {
+    return DIRT;
+  } else if(difference < 6) {
+    return biome > 1 ? GRASS : SHRUB;
+  } else if(difference < 10) {
+    return biome > 1 ? FULL_GRASS : FULL_SHRUB;
+  } else if(difference < 16) {
+    return STONE;
+  } else if(difference < 18) {
+    return SNOW;
+  }
+  return AIR;
+}
+
+// Height of the highest block and the block itself in the column at world
+// coordinates x, z, the same as generate would produce but without voxels.
+void ChunkTerrain::sampleSurface(const PerlinNoise& perlin, int32_t x, int32_t z, int& height, uint8_t& block) {
+  int32_t gridX = floorDiv(x, CHUNK_SIZE.x);
+  int32_t gridZ = floorDiv(z, CHUNK_SIZE.z);
+  int32_t localX = x - gridX * CHUNK_SIZE.x;
+  int32_t localZ = z - gridZ * CHUNK_SIZE.z;
+  double biome = columnBiome(perlin, gridX, gridZ, localX, localZ);
+  int y = std::max(columnHeight(perlin, gridX, gridZ, localX, localZ), WATER_LEVEL) - 1;
+  while(y > 0 && layerBlock(y, biome) == AIR) y--;
+  height = y + 1;
+  block = layerBlock(y, biome);
+}
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "chunk_noise.hpp"
+
+#include <glm/common.hpp>
+#include <glm/fwd.hpp>
+#include <vector>
+#include <cstdint>
+
+#define INVALID             -1
+#define AIR                 0
+#define DIRT                1
+#define GRASS               2
+#define FULL_GRASS          3
+#define STONE               4
+#define SNOW                5
+#define SAND                6
+#define WATER               7
+#define SHRUB               8
+#define FULL_SHRUB          9
+
+namespace app {
+
+// The terrain generator on its own, with no dependency on the engine, so it
+// can be run and measured without a GPU.
+class ChunkTerrain {
+
+  public:
+
+    static constexpr int WATER_LEVEL = 20;
+    static constexpr glm::ivec3 CHUNK_SIZE{32, 256, 32};
+
+    static void generate(uint32_t worldSeed, int32_t gridX, int32_t gridZ, std::vector<uint8_t>& cubes);
+
+    static double columnBiome(const PerlinNoise& perlin, int32_t gridX, int32_t gridZ, int32_t x, int32_t z);
+    static int columnHeight(const PerlinNoise& perlin, int32_t gridX, int32_t gridZ, int32_t x, int32_t z);
+    static uint8_t layerBlock(int32_t y, double biome);
+    static void sampleSurface(const PerlinNoise& perlin, int32_t x, int32_t z, int& height, uint8_t& block);
+
+    static int32_t floorDiv(int32_t a, int32_t b);
+
+};
+
+}
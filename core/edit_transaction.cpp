@@ -0,0 +1,145 @@
+#include "edit_transaction.hpp"
+
+#include <set>
+#include <cmath>
+#include <stdexcept>
+
+namespace app {
+
+//
+//  TRANSACTION RECORDING
+//
+
+// Edits are only recorded here. Nothing is written until commit, so the order
+// they were added in is the order they are applied in.
+
+void EditTransaction::fillBox(glm::ivec3 min, glm::ivec3 max, uint8_t block) {
+  ops.push_back(Op{FILL, glm::min(min, max), glm::max(min, max), block, AIR, {}, 0.f, 0});
+}
+
+void EditTransaction::sphere(glm::vec3 center, float radius, uint8_t block) {
+  glm::ivec3 min = glm::ivec3(glm::floor(center - radius));
+  glm::ivec3 max = glm::ivec3(glm::floor(center + radius));
+  ops.push_back(Op{SPHERE, min, max, block, AIR, center, radius, 0});
+}
+
+void EditTransaction::replace(glm::ivec3 min, glm::ivec3 max, uint8_t from, uint8_t to) {
+  ops.push_back(Op{REPLACE, glm::min(min, max), glm::max(min, max), to, from, {}, 0.f, 0});
+}
+
+void EditTransaction::paste(glm::ivec3 origin, const Template& blocks) {
+  if(blocks.size.x <= 0 || blocks.size.y <= 0 || blocks.size.z <= 0) return;
+  if(blocks.blocks.size() != static_cast<size_t>(blocks.size.x * blocks.size.y * blocks.size.z)) {
+    throw std::runtime_error("template size does not match its blocks");
+  }
+  pastes.push_back(blocks);
+  ops.push_back(Op{PASTE, origin, origin + blocks.size - 1, AIR, AIR, {}, 0.f, pastes.size() - 1});
+}
+
+//
+//  TRANSACTION COMMITTING
+//
+
+// Writes are grouped by chunk: every chunk an edit overlaps waits for its
+// worker once, takes all of the edits as row sized memory operations, and
+// then gets a single remesh together with the neighbours bordering the edits.
+// Chunks that are not loaded or not generated yet are left as they are, and
+// their number is returned, so zero means every edit was applied in full.
+size_t EditTransaction::commit() {
+  std::set<std::pair<int32_t, int32_t>> touched{};
+  std::set<std::pair<int32_t, int32_t>> dirty{};
+
+  for(const auto &op : ops) {
+    if(op.max.y < 0 || op.min.y >= Chunk::CHUNK_SIZE.y) continue;
+    const int32_t minX = ChunkTerrain::floorDiv(op.min.x, Chunk::CHUNK_SIZE.x);
+    const int32_t maxX = ChunkTerrain::floorDiv(op.max.x, Chunk::CHUNK_SIZE.x);
+    const int32_t minZ = ChunkTerrain::floorDiv(op.min.z, Chunk::CHUNK_SIZE.z);
+    const int32_t maxZ = ChunkTerrain::floorDiv(op.max.z, Chunk::CHUNK_SIZE.z);
+    for(int32_t gridZ = minZ; gridZ <= maxZ; gridZ++) {
+      for(int32_t gridX = minX; gridX <= maxX; gridX++) {
+        touched.insert({gridX, gridZ});
+        dirty.insert({gridX, gridZ});
+      }
+      if(ChunkTerrain::floorDiv(op.min.x - 1, Chunk::CHUNK_SIZE.x) < minX) dirty.insert({minX - 1, gridZ});
+      if(ChunkTerrain::floorDiv(op.max.x + 1, Chunk::CHUNK_SIZE.x) > maxX) dirty.insert({maxX + 1, gridZ});
+    }
+    for(int32_t gridX = minX; gridX <= maxX; gridX++) {
+      if(ChunkTerrain::floorDiv(op.min.z - 1, Chunk::CHUNK_SIZE.z) < minZ) dirty.insert({gridX, minZ - 1});
+      if(ChunkTerrain::floorDiv(op.max.z + 1, Chunk::CHUNK_SIZE.z) > maxZ) dirty.insert({gridX, maxZ + 1});
+    }
+  }
+
+  size_t skipped = 0;
+  for(const auto &[gridX, gridZ] : touched) {
+    Chunk* chunk = Chunk::getChunk(gridX, gridZ);
+    if(chunk == nullptr || !chunk->generated) {
+      skipped++;
+      continue;
+    }
+    chunk->resetThread();
+    for(const auto &op : ops) {
+      apply(op, chunk);
+    }
+    chunk->modified = true;
+  }
+
+  for(const auto &[gridX, gridZ] : dirty) {
+    Chunk::remesh(gridX, gridZ);
+  }
+
+  ops.clear();
+  pastes.clear();
+  return skipped;
+}
+
+void EditTransaction::apply(const Op& op, Chunk* chunk) {
+  const glm::ivec3 size = Chunk::CHUNK_SIZE;
+  const glm::ivec3 offset{chunk->gridX * size.x, 0, chunk->gridZ * size.z};
+  const glm::ivec3 min = glm::max(op.min - offset, glm::ivec3(0));
+  const glm::ivec3 max = glm::min(op.max - offset, size - 1);
+  if(min.x > max.x || min.y > max.y || min.z > max.z) return;
+
+  uint8_t* cubes = chunk->cubes.data();
+  auto row = [&](int y, int z) { return cubes + (y * size.x) + (z * size.x * size.y); };
+
+  for(int z = min.z; z <= max.z; z++) {
+    for(int y = min.y; y <= max.y; y++) {
+      uint8_t* blocks = row(y, z);
+      switch(op.type) {
+        case FILL:
+          std::fill(blocks + min.x, blocks + max.x + 1, op.block);
+          break;
+        case REPLACE:
+          std::replace(blocks + min.x, blocks + max.x + 1, op.from, op.block);
+          break;
+        case SPHERE: {
+          float dy = y + offset.y + 0.5f - op.center.y;
+          float dz = z + offset.z + 0.5f - op.center.z;
+          float remaining = op.radius * op.radius - dy * dy - dz * dz;
+          if(remaining < 0.f) break;
+          float half = sqrt(remaining);
+          int first = std::max(static_cast<int>(ceil(op.center.x - half - 0.5f)) - offset.x, min.x);
+          int last = std::min(static_cast<int>(floor(op.center.x + half - 0.5f)) - offset.x, max.x);
+          if(first <= last) std::fill(blocks + first, blocks + last + 1, op.block);
+          break;
+        }
+        case PASTE: {
+          const Template& paste = pastes[op.pasteIndex];
+          const glm::ivec3 local = glm::ivec3(min.x, y, z) + offset - op.min;
+          const uint8_t* source = paste.blocks.data() + local.x + (local.y * paste.size.x) + (local.z * paste.size.x * paste.size.y);
+          const int length = max.x - min.x + 1;
+          if(std::find(source, source + length, static_cast<uint8_t>(INVALID)) == source + length) {
+            std::copy(source, source + length, blocks + min.x);
+            break;
+          }
+          for(int x = 0; x < length; x++) {
+            if(source[x] != static_cast<uint8_t>(INVALID)) blocks[min.x + x] = source[x];
+          }
+          break;
+        }
+      }
+    }
+  }
+}
+
+}
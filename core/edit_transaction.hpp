@@ -0,0 +1,57 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <glm/common.hpp>
+#include <glm/fwd.hpp>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace app {
+
+class EditTransaction {
+
+  public:
+
+    // Blocks are stored x + y * size.x + z * size.x * size.y. Cells holding
+    // INVALID are left untouched when the template is pasted.
+    struct Template {
+      glm::ivec3 size{0};
+      std::vector<uint8_t> blocks{};
+    };
+
+    EditTransaction() {};
+    ~EditTransaction() {};
+
+    EditTransaction(const EditTransaction&) = delete;
+    EditTransaction operator=(const EditTransaction&) = delete;
+
+    void fillBox(glm::ivec3 min, glm::ivec3 max, uint8_t block);
+    void sphere(glm::vec3 center, float radius, uint8_t block);
+    void replace(glm::ivec3 min, glm::ivec3 max, uint8_t from, uint8_t to);
+    void paste(glm::ivec3 origin, const Template& blocks);
+
+    size_t commit();
+
+  private:
+
+    enum OpType { FILL, SPHERE, REPLACE, PASTE };
+
+    struct Op {
+      OpType type;
+      glm::ivec3 min, max;
+      uint8_t block, from;
+      glm::vec3 center;
+      float radius;
+      size_t pasteIndex;
+    };
+
+    void apply(const Op& op, Chunk* chunk);
+
+    std::vector<Op> ops{};
+    std::vector<Template> pastes{};
+
+};
+
+}
@@ -0,0 +1,265 @@
+#include "region.hpp"
+#include "chunk_terrain.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace app {
+
+//
+//  REGION FILE STATE
+//
+
+static constexpr auto FLUSH_INTERVAL = std::chrono::seconds(5);
+static constexpr uint32_t GROWTH_SECTORS = 64;
+static constexpr char MAGIC[4] = {'X', 'E', 'R', 'G'};
+
+static std::map<std::pair<int32_t, int32_t>, Region*> regions{};
+static std::string directory{};
+static std::mutex regionLock{};
+static std::condition_variable flushSignal{};
+static std::thread* flushWorker = nullptr;
+static bool running = false;
+
+//
+//  CHUNK PAYLOAD COMPRESSION
+//
+
+// Chunk voxels are stored as (block, run length) triplets. Columns of air and
+// stone compress very well this way and decoding is a handful of memsets.
+static void compress(const std::vector<uint8_t>& cubes, std::vector<uint8_t>& payload) {
+  payload.clear();
+  size_t i = 0;
+  while(i < cubes.size()) {
+    uint8_t block = cubes[i];
+    uint32_t run = 1;
+    while(i + run < cubes.size() && cubes[i + run] == block && run < UINT16_MAX) run++;
+    payload.push_back(block);
+    payload.push_back(static_cast<uint8_t>(run & 0xFF));
+    payload.push_back(static_cast<uint8_t>(run >> 8));
+    i += run;
+  }
+}
+
+static bool decompress(const uint8_t* payload, size_t size, std::vector<uint8_t>& cubes) {
+  if(size % 3 != 0) return false;
+  size_t n = 0;
+  for(size_t i = 0; i < size; i += 3) {
+    size_t run = payload[i + 1] | (payload[i + 2] << 8);
+    if(n + run > cubes.size()) return false;
+    std::memset(cubes.data() + n, payload[i], run);
+    n += run;
+  }
+  return n == cubes.size();
+}
+
+//
+//  REGION CONSTRUCTORS AND DECONSTUCTORS
+//
+
+Region::Region(int32_t regionX, int32_t regionZ, const std::string& filePath)
+  : regionX{regionX},
+    regionZ{regionZ} {
+  mapped = nullptr;
+  mappedSize = 0;
+  dirty = false;
+  used = true;
+
+  file = ::open(filePath.c_str(), O_RDWR | O_CREAT, 0644);
+  if(file < 0) {
+    throw std::runtime_error("failed to open region file " + filePath);
+  }
+
+  struct stat info;
+  fstat(file, &info);
+  size_t size = static_cast<size_t>(info.st_size);
+
+  bool valid = size >= HEADER_SECTORS * SECTOR_SIZE;
+  if(valid) {
+    remap(size);
+    valid = std::memcmp(header()->magic, MAGIC, sizeof(MAGIC)) == 0 && header()->version == VERSION;
+  }
+
+  if(!valid) {
+    size = HEADER_SECTORS * SECTOR_SIZE;
+    if(ftruncate(file, 0) != 0 || ftruncate(file, size) != 0) {
+      throw std::runtime_error("failed to initialize region file " + filePath);
+    }
+    remap(size);
+    std::memcpy(header()->magic, MAGIC, sizeof(MAGIC));
+    header()->version = VERSION;
+    dirty = true;
+  }
+}
+
+Region::~Region() {
+  sync(true);
+  if(mapped != nullptr) munmap(mapped, mappedSize);
+  ::close(file);
+}
+
+//
+//  REGION OPENING AND CLOSING
+//
+
+void Region::open(const std::string& saveDirectory) {
+  close();
+  std::lock_guard<std::mutex> lock(regionLock);
+  directory = saveDirectory;
+  std::filesystem::create_directories(directory);
+  running = true;
+  flushWorker = new std::thread(flushRegions);
+}
+
+void Region::close() {
+  {
+    std::lock_guard<std::mutex> lock(regionLock);
+    if(!running) return;
+    running = false;
+  }
+  flushSignal.notify_all();
+  flushWorker->join();
+  delete flushWorker;
+  flushWorker = nullptr;
+
+  std::lock_guard<std::mutex> lock(regionLock);
+  for(const auto &[key, region]: regions) {
+    delete region;
+  }
+  regions.clear();
+}
+
+Region* Region::getRegion(int32_t gridX, int32_t gridZ) {
+  int32_t regionX = ChunkTerrain::floorDiv(gridX, REGION_SIZE);
+  int32_t regionZ = ChunkTerrain::floorDiv(gridZ, REGION_SIZE);
+  auto it = regions.find({regionX, regionZ});
+  if(it != regions.end()) {
+    it->second->used = true;
+    return it->second;
+  }
+  std::string filePath = directory + "/r." + std::to_string(regionX) + "." + std::to_string(regionZ) + ".region";
+  Region* region = new Region(regionX, regionZ, filePath);
+  regions[{regionX, regionZ}] = region;
+  return region;
+}
+
+// Runs on its own thread while the regions are open. Dirty mappings are handed
+// to the kernel every interval and regions nobody touched since the last pass
+// are unmapped so long walks don't accumulate open files.
+void Region::flushRegions() {
+  std::unique_lock<std::mutex> lock(regionLock);
+  while(running) {
+    flushSignal.wait_for(lock, FLUSH_INTERVAL, []{ return !running; });
+    if(!running) break;
+    for(auto it = regions.begin(); it != regions.end();) {
+      Region* region = it->second;
+      region->sync(false);
+      if(!region->used) {
+        delete region;
+        it = regions.erase(it);
+      } else {
+        region->used = false;
+        it++;
+      }
+    }
+  }
+}
+
+//
+//  CHUNK LOADING AND SAVING
+//
+
+bool Region::loadChunk(int32_t gridX, int32_t gridZ, std::vector<uint8_t>& cubes) {
+  std::lock_guard<std::mutex> lock(regionLock);
+  if(!running) return false;
+  Region* region = getRegion(gridX, gridZ);
+  uint32_t localX = gridX - region->regionX * REGION_SIZE;
+  uint32_t localZ = gridZ - region->regionZ * REGION_SIZE;
+  return region->read(localX + localZ * REGION_SIZE, cubes);
+}
+
+void Region::saveChunk(int32_t gridX, int32_t gridZ, const std::vector<uint8_t>& cubes) {
+  std::lock_guard<std::mutex> lock(regionLock);
+  if(!running) return;
+  Region* region = getRegion(gridX, gridZ);
+  uint32_t localX = gridX - region->regionX * REGION_SIZE;
+  uint32_t localZ = gridZ - region->regionZ * REGION_SIZE;
+  region->write(localX + localZ * REGION_SIZE, cubes);
+}
+
+//
+//  REGION FILE ACCESS
+//
+
+bool Region::read(uint32_t index, std::vector<uint8_t>& cubes) {
+  const Entry entry = header()->entries[index];
+  if(entry.sector == 0) return false;
+  size_t offset = static_cast<size_t>(entry.sector) * SECTOR_SIZE;
+  if(offset + entry.size > mappedSize) return false;
+  return decompress(mapped + offset, entry.size, cubes);
+}
+
+void Region::write(uint32_t index, const std::vector<uint8_t>& cubes) {
+  static thread_local std::vector<uint8_t> payload{};
+  compress(cubes, payload);
+
+  const Entry entry = header()->entries[index];
+  uint32_t sectors = (payload.size() + SECTOR_SIZE - 1) / SECTOR_SIZE;
+  uint32_t sector = entry.sector;
+
+  // Rewrite in place when the new payload fits the old slot, otherwise append.
+  // Abandoned slots are not reclaimed.
+  if(sector == 0 || (entry.size + SECTOR_SIZE - 1) / SECTOR_SIZE < sectors) {
+    sector = endSector();
+  }
+
+  size_t end = static_cast<size_t>(sector + sectors) * SECTOR_SIZE;
+  if(end > mappedSize) {
+    size_t size = end + GROWTH_SECTORS * SECTOR_SIZE;
+    if(ftruncate(file, size) != 0) {
+      throw std::runtime_error("failed to grow region file");
+    }
+    remap(size);
+  }
+
+  std::memcpy(mapped + static_cast<size_t>(sector) * SECTOR_SIZE, payload.data(), payload.size());
+  header()->entries[index] = Entry{sector, static_cast<uint32_t>(payload.size())};
+  dirty = true;
+}
+
+uint32_t Region::endSector() {
+  uint32_t end = HEADER_SECTORS;
+  for(const Entry &entry: header()->entries) {
+    if(entry.sector == 0) continue;
+    end = std::max(end, entry.sector + (entry.size + SECTOR_SIZE - 1) / SECTOR_SIZE);
+  }
+  return end;
+}
+
+void Region::remap(size_t size) {
+  if(mapped != nullptr) {
+    munmap(mapped, mappedSize);
+  }
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  if(data == MAP_FAILED) {
+    throw std::runtime_error("failed to map region file");
+  }
+  mapped = static_cast<uint8_t*>(data);
+  mappedSize = size;
+}
+
+void Region::sync(bool blocking) {
+  if(!dirty || mapped == nullptr) return;
+  msync(mapped, mappedSize, blocking ? MS_SYNC : MS_ASYNC);
+  dirty = false;
+}
+
+}
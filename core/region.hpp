@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <map>
+#include <cstdint>
+
+namespace app {
+
+class Region {
+
+  public:
+
+    static constexpr int REGION_SIZE = 32;
+    static constexpr uint32_t SECTOR_SIZE = 4096;
+    static constexpr uint32_t VERSION = 1;
+
+    static void open(const std::string& directory);
+    static void close();
+
+    static bool loadChunk(int32_t gridX, int32_t gridZ, std::vector<uint8_t>& cubes);
+    static void saveChunk(int32_t gridX, int32_t gridZ, const std::vector<uint8_t>& cubes);
+
+  private:
+
+    struct Entry {
+      uint32_t sector;
+      uint32_t size;
+    };
+
+    struct Header {
+      char magic[4];
+      uint32_t version;
+      Entry entries[REGION_SIZE * REGION_SIZE];
+    };
+
+    static constexpr uint32_t HEADER_SECTORS = (sizeof(Header) + SECTOR_SIZE - 1) / SECTOR_SIZE;
+
+    Region(int32_t regionX, int32_t regionZ, const std::string& filePath);
+    ~Region();
+
+    static Region* getRegion(int32_t gridX, int32_t gridZ);
+    static void flushRegions();
+
+    bool read(uint32_t index, std::vector<uint8_t>& cubes);
+    void write(uint32_t index, const std::vector<uint8_t>& cubes);
+    void remap(size_t size);
+    uint32_t endSector();
+    void sync(bool blocking);
+
+    Header* header() { return reinterpret_cast<Header*>(mapped); }
+
+    const int32_t regionX, regionZ;
+
+    int file;
+    uint8_t* mapped;
+    size_t mappedSize;
+    bool dirty;
+    bool used;
+
+};
+
+}
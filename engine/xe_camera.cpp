@@ -28,6 +28,7 @@ void Camera::setPerspectiveProjection(float fovy, float aspect, float near, floa
 }
 
 void Camera::setViewDirection(glm::vec3 position, glm::vec3 direction, glm::vec3 up) {
+  viewPosition = position;
   const glm::vec3 w{glm::normalize(direction)};
   const glm::vec3 u{glm::normalize(glm::cross(w, up))};
   const glm::vec3 v{glm::cross(w, u)};
@@ -52,6 +53,7 @@ void Camera::setViewTarget(glm::vec3 position, glm::vec3 target, glm::vec3 up) {
 }
 
 void Camera::setViewYXZ(glm::vec3 position, glm::vec3 rotation) {
+  viewPosition = position;
   const float c3 = glm::cos(rotation.z);
   const float s3 = glm::sin(rotation.z);
   const float c2 = glm::cos(rotation.x);
@@ -27,10 +27,12 @@ class Camera {
 
     const glm::mat4& getProjection() const { return projectionMatrix; }
     const glm::mat4& getView() const { return viewMatrix; }
+    const glm::vec3& getPosition() const { return viewPosition; }
 
   private:
     glm::mat4 projectionMatrix{1.f};
     glm::mat4 viewMatrix{1.f};
+    glm::vec3 viewPosition{0.f};
 
 };
 
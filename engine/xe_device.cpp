@@ -1,7 +1,10 @@
 #include "xe_device.hpp"
+#include "xe_trace.hpp"
 
 // std headers
+#include <algorithm>
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <unordered_set>
@@ -54,10 +57,14 @@ Device::Device(Window &window) : window{window} {
   pickPhysicalDevice();
   createLogicalDevice();
   createCommandPool();
+  createPipelineCache();
 }
 
 Device::~Device() {
+  savePipelineCache();
+  vkDestroyPipelineCache(device_, pipelineCache, nullptr);
   vkDestroyCommandPool(device_, commandPool, nullptr);
+  vkDestroyCommandPool(device_, uploadCommandPool, nullptr);
   vkDestroyDevice(device_, nullptr);
 
   if (enableValidationLayers) {
@@ -168,9 +175,22 @@ void Device::createLogicalDevice() {
     queueCreateInfos.push_back(queueCreateInfo);
   }
 
+  // BC compression is only used by baked textures, which are left unused on
+  // devices without it.
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+  textureCompressionBC = supportedFeatures.textureCompressionBC;
+
+  // Pipeline statistics are only collected by the GPU profiler. Passes drawn
+  // from secondary command buffers need them inherited as well.
+  pipelineStatistics = supportedFeatures.pipelineStatisticsQuery && supportedFeatures.inheritedQueries;
+
   VkPhysicalDeviceFeatures deviceFeatures = {};
   deviceFeatures.samplerAnisotropy = VK_TRUE;
   deviceFeatures.fillModeNonSolid = VK_TRUE;
+  deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+  deviceFeatures.pipelineStatisticsQuery = pipelineStatistics;
+  deviceFeatures.inheritedQueries = pipelineStatistics;
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -179,8 +199,9 @@ void Device::createLogicalDevice() {
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
   createInfo.pEnabledFeatures = &deviceFeatures;
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+  auto extensions = getDeviceExtensions();
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+  createInfo.ppEnabledExtensionNames = extensions.data();
 
   // might not really be necessary anymore because device specific validation layers
   // have been deprecated
@@ -211,17 +232,81 @@ void Device::createCommandPool() {
   if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
     throw std::runtime_error("failed to create command pool!");
   }
+
+  // Uploads can be recorded from threads other than the one drawing frames,
+  // and a command pool may only be used by one thread at a time.
+  if (vkCreateCommandPool(device_, &poolInfo, nullptr, &uploadCommandPool) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create upload command pool!");
+  }
+}
+
+// A cache written by another driver or device is ignored rather than handed
+// to the driver, which may not validate it as carefully. The header every
+// cache starts with names the vendor, device and driver that wrote it.
+void Device::createPipelineCache() {
+  std::vector<char> data{};
+  std::ifstream file{PIPELINE_CACHE_PATH, std::ios::ate | std::ios::binary};
+  if (file.is_open()) {
+    data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), data.size());
+  }
+
+  VkPipelineCacheHeaderVersionOne header{};
+  if (data.size() >= sizeof(header)) {
+    memcpy(&header, data.data(), sizeof(header));
+  }
+  bool valid = data.size() >= sizeof(header) &&
+      header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+      header.vendorID == properties.vendorID &&
+      header.deviceID == properties.deviceID &&
+      memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+  if (!valid) {
+    data.clear();
+  }
+
+  VkPipelineCacheCreateInfo cacheInfo{};
+  cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  cacheInfo.initialDataSize = data.size();
+  cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+  if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create pipeline cache!");
+  }
+  std::cout << "Pipeline cache: " << (valid ? "loaded " + std::to_string(data.size()) + " bytes" : "empty") << std::endl;
+}
+
+// A cache that can't be written only costs the next startup its compile time,
+// so failing here is not an error.
+void Device::savePipelineCache() {
+  size_t size = 0;
+  if (vkGetPipelineCacheData(device_, pipelineCache, &size, nullptr) != VK_SUCCESS) return;
+  std::vector<char> data(size);
+  if (vkGetPipelineCacheData(device_, pipelineCache, &size, data.data()) != VK_SUCCESS) return;
+
+  std::ofstream file{PIPELINE_CACHE_PATH, std::ios::binary};
+  if (!file.is_open()) {
+    std::cerr << "failed to save pipeline cache: " << PIPELINE_CACHE_PATH << std::endl;
+    return;
+  }
+  file.write(data.data(), size);
 }
 
-void Device::createSurface() { window.createWindowSurface(instance, &surface_); }
+void Device::createSurface() {
+  if (window.isOffscreen()) {
+    surface_ = VK_NULL_HANDLE;
+    return;
+  }
+  window.createWindowSurface(instance, &surface_);
+}
 
 bool Device::isDeviceSuitable(VkPhysicalDevice device) {
   QueueFamilyIndices indices = findQueueFamilies(device);
 
   bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-  bool swapChainAdequate = false;
-  if (extensionsSupported) {
+  bool swapChainAdequate = window.isOffscreen();
+  if (extensionsSupported && !swapChainAdequate) {
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
     swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
   }
@@ -281,11 +366,13 @@ bool Device::checkValidationLayerSupport() {
 }
 
 std::vector<const char *> Device::getRequiredExtensions() {
-  uint32_t glfwExtensionCount = 0;
-  const char **glfwExtensions;
-  glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-  std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  std::vector<const char *> extensions{};
+  if (!window.isOffscreen()) {
+    uint32_t glfwExtensionCount = 0;
+    const char **glfwExtensions;
+    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  }
 
   if (enableValidationLayers) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -328,7 +415,8 @@ bool Device::checkDeviceExtensionSupport(VkPhysicalDevice device) {
       &extensionCount,
       availableExtensions.data());
 
-  std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+  auto extensions = getDeviceExtensions();
+  std::set<std::string> requiredExtensions(extensions.begin(), extensions.end());
 
   for (const auto &extension : availableExtensions) {
     requiredExtensions.erase(extension.extensionName);
@@ -337,6 +425,15 @@ bool Device::checkDeviceExtensionSupport(VkPhysicalDevice device) {
   return requiredExtensions.empty();
 }
 
+// Offscreen rendering never presents, so it has no use for a swap chain.
+std::vector<const char *> Device::getDeviceExtensions() {
+  std::vector<const char *> extensions = deviceExtensions;
+  if (window.isOffscreen()) {
+    extensions.erase(std::find(extensions.begin(), extensions.end(), VK_KHR_SWAPCHAIN_EXTENSION_NAME));
+  }
+  return extensions;
+}
+
 QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device) {
   QueueFamilyIndices indices;
 
@@ -353,7 +450,12 @@ QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device) {
       indices.graphicsFamilyHasValue = true;
     }
     VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+    // Without a surface the graphics queue stands in for the present queue.
+    if (window.isOffscreen()) {
+      presentSupport = queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT ? VK_TRUE : VK_FALSE;
+    } else {
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+    }
     if (queueFamily.queueCount > 0 && presentSupport) {
       indices.presentFamily = i;
       indices.presentFamilyHasValue = true;
@@ -454,11 +556,15 @@ void Device::createBuffer(
   vkBindBufferMemory(device_, buffer, bufferMemory, 0);
 }
 
+// The upload pool stays locked from begin to end, since recording into a
+// command buffer also counts as using the pool it came from.
 VkCommandBuffer Device::beginSingleTimeCommands() {
+  uploadLock.lock();
+
   VkCommandBufferAllocateInfo allocInfo{};
   allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
   allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  allocInfo.commandPool = commandPool;
+  allocInfo.commandPool = uploadCommandPool;
   allocInfo.commandBufferCount = 1;
 
   VkCommandBuffer commandBuffer;
@@ -473,6 +579,7 @@ VkCommandBuffer Device::beginSingleTimeCommands() {
 }
 
 void Device::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
+  XE_TRACE_SCOPE("Device::endSingleTimeCommands");
   vkEndCommandBuffer(commandBuffer);
 
   VkSubmitInfo submitInfo{};
@@ -480,13 +587,30 @@ void Device::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &commandBuffer;
 
-  vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-  vkQueueWaitIdle(graphicsQueue_);
+  VkFenceCreateInfo fenceInfo{};
+  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  VkFence fence;
+  vkCreateFence(device_, &fenceInfo, nullptr, &fence);
+
+  {
+    std::lock_guard<std::mutex> lock(queueLock);
+    vkQueueSubmit(graphicsQueue_, 1, &submitInfo, fence);
+  }
+  vkWaitForFences(device_, 1, &fence, VK_TRUE, UINT64_MAX);
+  vkDestroyFence(device_, fence, nullptr);
+
+  vkFreeCommandBuffers(device_, uploadCommandPool, 1, &commandBuffer);
+
+  uploadLock.unlock();
+}
 
-  vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+void Device::waitIdle() {
+  std::lock_guard<std::mutex> lock(queueLock);
+  vkDeviceWaitIdle(device_);
 }
 
 void Device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+  XE_TRACE_SCOPE("Device::copyBuffer");
   VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
   VkBufferCopy copyRegion{};
@@ -500,6 +624,7 @@ void Device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize siz
 
 void Device::copyBufferToImage(
     VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount) {
+  XE_TRACE_SCOPE("Device::copyBufferToImage");
   VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
   VkBufferImageCopy region{};
@@ -4,6 +4,7 @@
 
 #include <string>
 #include <vector>
+#include <mutex>
 
 namespace xe {
 
@@ -29,6 +30,8 @@ class Device {
   const bool enableValidationLayers = true;
 #endif
 
+  static constexpr const char* PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+
   Device(Window &window);
   ~Device();
 
@@ -38,12 +41,16 @@ class Device {
   Device &operator=(Device &&) = delete;
 
   VkCommandPool getCommandPool() { return commandPool; }
+  VkPipelineCache getPipelineCache() { return pipelineCache; }
+  std::mutex& getQueueLock() { return queueLock; }
   VkDevice device() { return device_; }
   VkSurfaceKHR surface() { return surface_; }
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
   VkSampleCountFlagBits getSamples() { return msaaSamples; }
   float getAnisotropy() { return samplerAnisotropy; }
+  bool supportsTextureCompressionBC() { return textureCompressionBC; }
+  bool supportsPipelineStatistics() { return pipelineStatistics; }
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -63,6 +70,7 @@ class Device {
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
   void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
+  void waitIdle();
 
   void createImageWithInfo(
       const VkImageCreateInfo &imageInfo,
@@ -79,9 +87,12 @@ class Device {
   void pickPhysicalDevice();
   void createLogicalDevice();
   void createCommandPool();
+  void createPipelineCache();
+  void savePipelineCache();
 
   bool isDeviceSuitable(VkPhysicalDevice device);
   std::vector<const char *> getRequiredExtensions();
+  std::vector<const char *> getDeviceExtensions();
   bool checkValidationLayerSupport();
   QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
   void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
@@ -95,6 +106,11 @@ class Device {
   VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
   Window &window;
   VkCommandPool commandPool;
+  VkCommandPool uploadCommandPool;
+  VkPipelineCache pipelineCache;
+
+  std::mutex queueLock;
+  std::mutex uploadLock;
 
   VkDevice device_;
   VkSurfaceKHR surface_;
@@ -103,6 +119,8 @@ class Device {
 
   VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
   float samplerAnisotropy = 1;
+  bool textureCompressionBC = false;
+  bool pipelineStatistics = false;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
   const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_MAINTENANCE1_EXTENSION_NAME};
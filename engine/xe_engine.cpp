@@ -8,30 +8,80 @@ Engine* Engine::getInstance() {
   return _instance;
 }
 
-Engine::Engine(int width, int height, std::string name, const char *icon) : xeWindow{width, height, name, icon}, 
+Engine::Engine(int width, int height, std::string name, const char *icon, SwapChain::Config config) : xeWindow{width, height, name, icon, config.offscreen}, 
   xeDevice{xeWindow}, 
-  xeRenderer{xeWindow, xeDevice},
+  xeRenderer{xeWindow, xeDevice, config},
   xeCamera{},
   xeInput{xeWindow} {
-  alutInit(0, NULL);
-  std::cout << "Audio device: " << alcGetString(NULL, ALC_DEFAULT_DEVICE_SPECIFIER) << "\n";
+  currentTime = std::chrono::high_resolution_clock::now();
+  // Offscreen runs are meant for machines without a display, which often
+  // have no audio device either.
+  if(!xeWindow.isOffscreen()) {
+    alutInit(0, NULL);
+    std::cout << "Audio device: " << alcGetString(NULL, ALC_DEFAULT_DEVICE_SPECIFIER) << "\n";
+  }
   _instance = this;
 };
 
 Engine::~Engine() {
+  try { stopRenderThread(); } catch(...) {};
   Model::submitDeleteQueue(true);
   Image::submitDeleteQueue(true);
-  alutExit();
+  if(!xeWindow.isOffscreen()) alutExit();
 };
 
 bool Engine::poll() {
-  glfwPollEvents();
+  {
+    FrameStats::Scope scope{FrameStats::POLL};
+    if(!xeWindow.isOffscreen()) glfwPollEvents();
+  }
   auto newTime = std::chrono::high_resolution_clock::now();
   frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
   currentTime = newTime;
+  return !xeWindow.shouldClose() && (renderThread == nullptr || rendering);
+}
+
+bool Engine::beginFrame() {
+  if(!xeRenderer.beginFrame()) return false;
   float aspect = xeRenderer.getAspectRatio();
-  xeCamera.setPerspectiveProjection(glm::radians(FOV), aspect, 0.1f, 1000.f);
-  return !xeWindow.shouldClose();
+  xeCamera.setPerspectiveProjection(glm::radians(FOV), aspect, 0.1f, farPlane);
+  return true;
+}
+
+// Runs renderFrame in a loop on its own thread until stopped. Window events
+// still have to be polled from the thread that created the engine, and the
+// camera then belongs to the render thread. renderFrame returns false when no
+// frame could be drawn, for example while the window is minimized. If it
+// throws, the thread stops, poll returns false and stopRenderThread rethrows
+// the exception on the thread that owns the engine.
+void Engine::startRenderThread(std::function<bool()> renderFrame) {
+  stopRenderThread();
+  rendering = true;
+  renderThread = new std::thread([this, renderFrame]() {
+    try {
+      while(rendering) {
+        if(!renderFrame()) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      }
+    } catch(...) {
+      renderError = std::current_exception();
+      rendering = false;
+    }
+  });
+}
+
+void Engine::stopRenderThread() {
+  if(renderThread == nullptr) return;
+  rendering = false;
+  renderThread->join();
+  delete renderThread;
+  renderThread = nullptr;
+  if(renderError != nullptr) {
+    std::exception_ptr error = renderError;
+    renderError = nullptr;
+    std::rethrow_exception(error);
+  }
 }
 
 }
\ No newline at end of file
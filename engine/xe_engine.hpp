@@ -7,10 +7,16 @@
 #include "xe_descriptors.hpp"
 #include "xe_input.hpp"
 #include "xe_sound.hpp"
+#include "xe_frame_stats.hpp"
+#include "xe_trace.hpp"
 
 #include <chrono> 
 #include <string>
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <exception>
 #include <AL/alc.h> 
 #include <AL/alut.h>
 
@@ -20,7 +26,7 @@ class Engine {
 
   public:
 
-    Engine(int width, int height, std::string name, const char *icon);
+    Engine(int width, int height, std::string name, const char *icon, SwapChain::Config config = {});
 
     ~Engine();
 
@@ -29,13 +35,19 @@ class Engine {
 
     Input& getInput() {return xeInput;}
     Camera& getCamera() {return xeCamera;}
+    GpuProfiler& getGpuProfiler() {return xeRenderer.getProfiler();}
     
-    bool beginFrame() { return xeRenderer.beginFrame(); }
-    void endFrame() { xeRenderer.endFrame(); }
-    void close() { vkDeviceWaitIdle(xeDevice.device()); }
+    bool beginFrame();
+    void endFrame() { xeRenderer.endFrame(); FrameStats::endFrame(); }
+    void close() { xeDevice.waitIdle(); }
+    void captureFrame(const std::string &path) { xeRenderer.captureFrame(path); }
+
+    void startRenderThread(std::function<bool()> renderFrame);
+    void stopRenderThread();
 
     bool poll();
     float getFrameTime() { return frameTime; }
+    void setFarPlane(float distance) { farPlane = distance; }
 
     static Engine* getInstance();
 
@@ -51,6 +63,11 @@ class Engine {
     float frameTime;
 
     float FOV = 50.f;
+    float farPlane = 1000.f;
+
+    std::thread* renderThread = nullptr;
+    std::atomic<bool> rendering{false};
+    std::exception_ptr renderError{nullptr};
 
     friend class RenderSystem;
     friend class Image;
@@ -0,0 +1,115 @@
+#include "xe_frame_stats.hpp"
+
+#include <mutex>
+#include <deque>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+namespace xe {
+
+// Phases are added from both the simulation and the render thread, so every
+// access goes through one lock. It is taken a handful of times per frame.
+static std::mutex STATS_LOCK{};
+static FrameStats::Frame CURRENT{};
+static std::deque<FrameStats::Frame> HISTORY{};
+static bool KEEP_ALL = false;
+static std::chrono::steady_clock::time_point LAST_FRAME{};
+static bool STARTED = false;
+
+static const char* PHASE_NAMES[FrameStats::PHASE_COUNT] = {
+  "poll", "update", "chunks", "record", "submit", "present_wait", "fence_wait", "gpu"
+};
+
+void FrameStats::add(Phase phase, float milliseconds) {
+  std::lock_guard<std::mutex> lock(STATS_LOCK);
+  CURRENT.phases[phase] += milliseconds;
+}
+
+// The first call only starts the clock, since there is no previous frame to
+// measure against.
+void FrameStats::endFrame() {
+  auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(STATS_LOCK);
+  if(STARTED) {
+    CURRENT.frameTime = std::chrono::duration<float, std::milli>(now - LAST_FRAME).count();
+    HISTORY.push_back(CURRENT);
+    if(!KEEP_ALL && HISTORY.size() > HISTORY_SIZE) HISTORY.pop_front();
+  }
+  STARTED = true;
+  LAST_FRAME = now;
+  CURRENT = Frame{};
+}
+
+// Normally only the newest HISTORY_SIZE frames are kept. Replays and offscreen
+// runs turn this on so their percentiles and CSV cover every frame of the run
+// instead of just its end. Turning it off trims the history back.
+void FrameStats::keepAll(bool enabled) {
+  std::lock_guard<std::mutex> lock(STATS_LOCK);
+  KEEP_ALL = enabled;
+  while(!KEEP_ALL && HISTORY.size() > HISTORY_SIZE) HISTORY.pop_front();
+}
+
+// Nearest rank percentile of the frame times still in the history, p is
+// given from 0 to 100.
+float FrameStats::percentile(float p) {
+  std::vector<float> times{};
+  for(const auto &frame : history()) {
+    times.push_back(frame.frameTime);
+  }
+  if(times.empty()) return 0.f;
+  size_t rank = static_cast<size_t>(std::clamp(p, 0.f, 100.f) / 100.f * (times.size() - 1) + 0.5f);
+  std::nth_element(times.begin(), times.begin() + rank, times.end());
+  return times[rank];
+}
+
+float FrameStats::average(Phase phase) {
+  std::vector<Frame> frames = history();
+  if(frames.empty()) return 0.f;
+  float total = 0.f;
+  for(const auto &frame : frames) {
+    total += frame.phases[phase];
+  }
+  return total / frames.size();
+}
+
+// Oldest frame first.
+std::vector<FrameStats::Frame> FrameStats::history() {
+  std::lock_guard<std::mutex> lock(STATS_LOCK);
+  return std::vector<Frame>(HISTORY.begin(), HISTORY.end());
+}
+
+// The newest finished frame, or an empty one before the first has finished.
+FrameStats::Frame FrameStats::latest() {
+  std::lock_guard<std::mutex> lock(STATS_LOCK);
+  if(HISTORY.empty()) return Frame{};
+  return HISTORY.back();
+}
+
+void FrameStats::writeCsv(const std::string& path) {
+  std::ofstream file{path};
+  if(!file.is_open()) {
+    throw std::runtime_error("failed to open frame stats file: " + path);
+  }
+
+  file << "frame,frame_ms";
+  for(int i = 0; i < PHASE_COUNT; i++) {
+    file << "," << PHASE_NAMES[i] << "_ms";
+  }
+  file << "\n";
+
+  std::vector<Frame> frames = history();
+  for(size_t f = 0; f < frames.size(); f++) {
+    file << f << "," << frames[f].frameTime;
+    for(int i = 0; i < PHASE_COUNT; i++) {
+      file << "," << frames[f].phases[i];
+    }
+    file << "\n";
+  }
+}
+
+const char* FrameStats::getPhaseName(Phase phase) {
+  return PHASE_NAMES[phase];
+}
+
+}
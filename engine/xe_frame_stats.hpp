@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <array>
+#include <cstddef>
+
+namespace xe {
+
+class FrameStats {
+
+  public:
+
+    enum Phase { POLL, UPDATE, CHUNKS, RECORD, SUBMIT, PRESENT_WAIT, FENCE_WAIT, GPU, PHASE_COUNT };
+
+    static constexpr size_t HISTORY_SIZE = 1024;
+
+    // All times are in milliseconds. frameTime is measured between calls to
+    // endFrame, phases hold whatever was added to them in that time. GPU is
+    // the render pass time read back from the GPU profiler, so it trails the
+    // CPU phases by the number of frames in flight.
+    struct Frame {
+      float frameTime;
+      std::array<float, PHASE_COUNT> phases;
+    };
+
+    class Scope {
+      public:
+        Scope(Phase phase) : phase{phase}, start{std::chrono::steady_clock::now()} {}
+        ~Scope() { add(phase, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count()); }
+
+        Scope(const Scope&) = delete;
+        Scope operator=(const Scope&) = delete;
+
+      private:
+        Phase phase;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    static void add(Phase phase, float milliseconds);
+    static void endFrame();
+    static void keepAll(bool enabled);
+
+    static float percentile(float p);
+    static float average(Phase phase);
+    static std::vector<Frame> history();
+    static Frame latest();
+    static void writeCsv(const std::string& path);
+
+    static const char* getPhaseName(Phase phase);
+
+};
+
+}
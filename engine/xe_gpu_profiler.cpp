@@ -0,0 +1,162 @@
+#include "xe_gpu_profiler.hpp"
+
+#include <stdexcept>
+
+namespace xe {
+
+// One query pool per frame in flight, holding a begin and end timestamp for
+// each scope. A pool is only read back once the frame that wrote it has
+// passed its fence again, so results always trail the current frame by the
+// number of frames in flight and reading them never stalls. Pipeline
+// statistics get a pool of their own per frame in flight, with one query.
+GpuProfiler::GpuProfiler(Device &device, int framesInFlight) : xeDevice{device} {
+  supported = device.properties.limits.timestampComputeAndGraphics == VK_TRUE;
+  timestampPeriod = device.properties.limits.timestampPeriod;
+  if(!supported) return;
+
+  statisticsSupported = device.supportsPipelineStatistics();
+  if(statisticsSupported) {
+    statisticsPools.resize(framesInFlight);
+    statisticsBegun.resize(framesInFlight, false);
+    statisticsWritten.resize(framesInFlight, false);
+
+    VkQueryPoolCreateInfo statisticsInfo{};
+    statisticsInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    statisticsInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+    statisticsInfo.queryCount = 1;
+    statisticsInfo.pipelineStatistics = STATISTIC_FLAGS;
+
+    for(auto &pool : statisticsPools) {
+      if(vkCreateQueryPool(xeDevice.device(), &statisticsInfo, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline statistics query pool!");
+      }
+    }
+  }
+
+  queryPools.resize(framesInFlight);
+  scopes.resize(framesInFlight);
+
+  VkQueryPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  poolInfo.queryCount = MAX_SCOPES * 2;
+
+  for(auto &pool : queryPools) {
+    if(vkCreateQueryPool(xeDevice.device(), &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create timestamp query pool!");
+    }
+  }
+}
+
+GpuProfiler::~GpuProfiler() {
+  for(auto &pool : queryPools) {
+    vkDestroyQueryPool(xeDevice.device(), pool, nullptr);
+  }
+  for(auto &pool : statisticsPools) {
+    vkDestroyQueryPool(xeDevice.device(), pool, nullptr);
+  }
+}
+
+// Has to be recorded outside of a render pass, since the pool is reset here.
+void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int newFrameIndex) {
+  if(!supported) return;
+  frameIndex = newFrameIndex;
+  readResults(frameIndex);
+  scopes[frameIndex].clear();
+  vkCmdResetQueryPool(commandBuffer, queryPools[frameIndex], 0, MAX_SCOPES * 2);
+  if(statisticsSupported) {
+    statisticsBegun[frameIndex] = false;
+    statisticsWritten[frameIndex] = false;
+    vkCmdResetQueryPool(commandBuffer, statisticsPools[frameIndex], 0, 1);
+  }
+}
+
+// Returns -1 once MAX_SCOPES are open in a frame, endScope ignores it.
+int GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const std::string& name) {
+  if(!supported || scopes[frameIndex].size() >= MAX_SCOPES) return -1;
+  int scope = static_cast<int>(scopes[frameIndex].size());
+  scopes[frameIndex].push_back({name, false});
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPools[frameIndex], scope * 2);
+  return scope;
+}
+
+void GpuProfiler::endScope(VkCommandBuffer commandBuffer, int scope) {
+  if(!supported || scope < 0) return;
+  scopes[frameIndex][scope].ended = true;
+  vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPools[frameIndex], scope * 2 + 1);
+}
+
+// Only counts the statistics of the first call in a frame. A query can only
+// be begun once between resets, and the render pass is usually begun once a
+// frame anyway. Both calls have to be recorded outside of a render pass.
+void GpuProfiler::beginStatistics(VkCommandBuffer commandBuffer) {
+  if(!statisticsSupported || statisticsBegun[frameIndex]) return;
+  statisticsBegun[frameIndex] = true;
+  vkCmdBeginQuery(commandBuffer, statisticsPools[frameIndex], 0, 0);
+}
+
+void GpuProfiler::endStatistics(VkCommandBuffer commandBuffer) {
+  if(!statisticsSupported || !statisticsBegun[frameIndex] || statisticsWritten[frameIndex]) return;
+  statisticsWritten[frameIndex] = true;
+  vkCmdEndQuery(commandBuffer, statisticsPools[frameIndex], 0);
+}
+
+// Scopes that were begun but never ended have no end timestamp, and asking
+// for it would fail the whole read, so only the ended ones are queried.
+void GpuProfiler::readResults(int index) {
+  const std::vector<Scope>& written = scopes[index];
+
+  std::map<std::string, float> frame{};
+  for(size_t i = 0; i < written.size(); i++) {
+    if(!written[i].ended) continue;
+    uint64_t timestamps[2];
+    VkResult result = vkGetQueryPoolResults(
+      xeDevice.device(),
+      queryPools[index],
+      static_cast<uint32_t>(i * 2),
+      2,
+      sizeof(timestamps),
+      timestamps,
+      sizeof(uint64_t),
+      VK_QUERY_RESULT_64_BIT);
+    if(result != VK_SUCCESS) return;
+    frame[written[i].name] += (timestamps[1] - timestamps[0]) * timestampPeriod / 1000000.f;
+  }
+
+  Statistics frameStatistics{};
+  bool hasStatistics = statisticsSupported && statisticsWritten[index];
+  if(hasStatistics) {
+    // Results come in the order of the flag bits, vertex before fragment.
+    uint64_t counts[2];
+    VkResult result = vkGetQueryPoolResults(
+      xeDevice.device(),
+      statisticsPools[index],
+      0,
+      1,
+      sizeof(counts),
+      counts,
+      sizeof(counts),
+      VK_QUERY_RESULT_64_BIT);
+    if(result != VK_SUCCESS) return;
+    frameStatistics = {counts[0], counts[1]};
+  }
+
+  if(frame.empty() && !hasStatistics) return;
+  std::lock_guard<std::mutex> lock(resultLock);
+  results = std::move(frame);
+  if(hasStatistics) statistics = frameStatistics;
+}
+
+// Milliseconds spent by each named scope in the most recently read frame.
+// Scopes opened more than once in a frame are summed.
+std::map<std::string, float> GpuProfiler::getResults() {
+  std::lock_guard<std::mutex> lock(resultLock);
+  return results;
+}
+
+GpuProfiler::Statistics GpuProfiler::getStatistics() {
+  std::lock_guard<std::mutex> lock(resultLock);
+  return statistics;
+}
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "xe_device.hpp"
+
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstdint>
+
+namespace xe {
+
+class GpuProfiler {
+
+  public:
+
+    static constexpr uint32_t MAX_SCOPES = 32;
+    static constexpr VkQueryPipelineStatisticFlags STATISTIC_FLAGS =
+      VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+    // Shader invocations of the most recently read frame. Comparing them with
+    // the render pass time shows whether a frame is vertex or fragment bound.
+    struct Statistics {
+      uint64_t vertexInvocations;
+      uint64_t fragmentInvocations;
+    };
+
+    GpuProfiler(Device &device, int framesInFlight);
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler operator=(const GpuProfiler&) = delete;
+
+    void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+    int beginScope(VkCommandBuffer commandBuffer, const std::string& name);
+    void endScope(VkCommandBuffer commandBuffer, int scope);
+    void beginStatistics(VkCommandBuffer commandBuffer);
+    void endStatistics(VkCommandBuffer commandBuffer);
+
+    std::map<std::string, float> getResults();
+    Statistics getStatistics();
+    bool isSupported() const { return supported; }
+    VkQueryPipelineStatisticFlags getStatisticFlags() const { return statisticsSupported ? STATISTIC_FLAGS : 0; }
+
+  private:
+
+    struct Scope {
+      std::string name;
+      bool ended;
+    };
+
+    void readResults(int frameIndex);
+
+    Device &xeDevice;
+    bool supported{false};
+    bool statisticsSupported{false};
+    float timestampPeriod{1.f};
+    int frameIndex{0};
+
+    std::vector<VkQueryPool> queryPools{};
+    std::vector<std::vector<Scope>> scopes{};
+    std::vector<VkQueryPool> statisticsPools{};
+    std::vector<bool> statisticsBegun{};
+    std::vector<bool> statisticsWritten{};
+
+    std::mutex resultLock{};
+    std::map<std::string, float> results{};
+    Statistics statistics{};
+
+};
+
+}
@@ -1,13 +1,19 @@
 #include "xe_image.hpp"
 #include "xe_engine.hpp"
+#include "xe_trace.hpp"
 
 #include <vulkan/vulkan.h>
 #include <stdexcept>
 #include <memory>
 #include <cstring>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
 
 namespace xe {
 
@@ -15,8 +21,22 @@ namespace xe {
 //  CONSTRUCTORS AND DECONSTUCTORS
 //
 
-Image::Image(const std::string &filename, bool anisotropic) : xeDevice{Engine::getInstance()->xeDevice} {
-  createTextureImage(filename);
+// An array image has one layer per file, and is viewed as an array even when
+// there is only one.
+Image::Image(const std::vector<std::string> &filenames, bool array, bool anisotropic) : xeDevice{Engine::getInstance()->xeDevice} {
+  layerCount = static_cast<uint32_t>(filenames.size());
+  viewType = array ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+  format = VK_FORMAT_R8G8B8A8_SRGB;
+  createTextureImage(filenames);
+  createTextureImageView();
+  createTextureSampler(anisotropic);
+}
+
+Image::Image(const TextureFile &file, bool anisotropic) : xeDevice{Engine::getInstance()->xeDevice} {
+  layerCount = file.header.layers;
+  viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+  format = file.header.format == TextureFile::BC1 ? VK_FORMAT_BC1_RGBA_SRGB_BLOCK : VK_FORMAT_R8G8B8A8_SRGB;
+  createBakedTextureImage(file);
   createTextureImageView();
   createTextureSampler(anisotropic);
 }
@@ -36,7 +56,23 @@ static std::set<Image*> CREATED_IMAGES{};
 static std::set<Image*> DELETION_QUEUE{};
 
 Image* Image::createImage(const std::string &filename, bool anisotropic) {
-  Image* image = new Image(filename, anisotropic);
+  Image* image = new Image({filename}, false, anisotropic);
+  CREATED_IMAGES.insert(image);
+  return image;
+}
+
+// Every file has to be the same size.
+Image* Image::createImageArray(const std::vector<std::string> &filenames, bool anisotropic) {
+  if(filenames.empty()) {
+    throw std::runtime_error("an image array needs at least one file");
+  }
+  Image* image = new Image(filenames, true, anisotropic);
+  CREATED_IMAGES.insert(image);
+  return image;
+}
+
+Image* Image::createBakedImageArray(const TextureFile &file, bool anisotropic) {
+  Image* image = new Image(file, anisotropic);
   CREATED_IMAGES.insert(image);
   return image;
 }
@@ -65,16 +101,55 @@ void Image::submitDeleteQueue(bool purge) {
 //  IMAGE CREATION FUNCTIONS
 //
 
-void Image::createTextureImage(const std::string &filename) {
-  int texWidth, texHeight, texChannels;
-  stbi_uc* pixels = stbi_load(filename.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-  VkDeviceSize imageSize = texWidth * texHeight * 4;
-  mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
+// Decoding the files is the slow part of loading, so the layers are shared
+// out between worker threads. The upload is then recorded into one command
+// buffer, layout transitions, copy and mipmaps alike, and submitted once.
+void Image::createTextureImage(const std::vector<std::string> &filenames) {
+  std::vector<stbi_uc*> pixels(layerCount, nullptr);
+  std::vector<int> widths(layerCount);
+  std::vector<int> heights(layerCount);
+  {
+    XE_TRACE_SCOPE("Image::decode");
+    std::atomic<uint32_t> next{0};
+    auto decode = [&]() {
+      for (uint32_t layer = next++; layer < layerCount; layer = next++) {
+        int channels;
+        pixels[layer] = stbi_load(filenames[layer].c_str(), &widths[layer], &heights[layer], &channels, STBI_rgb_alpha);
+      }
+    };
+    std::vector<std::thread> workers{};
+    uint32_t workerCount = std::min(layerCount, std::max(std::thread::hardware_concurrency(), 1u));
+    for (uint32_t i = 1; i < workerCount; i++) {
+      workers.emplace_back(decode);
+    }
+    decode();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
 
-  if (!pixels) {
-      throw std::runtime_error("failed to load texture: " + filename);
+  auto freePixels = [&]() {
+    for (auto layer : pixels) {
+      if (layer) stbi_image_free(layer);
+    }
+  };
+  for (uint32_t layer = 0; layer < layerCount; layer++) {
+    if (!pixels[layer]) {
+      freePixels();
+      throw std::runtime_error("failed to load texture: " + filenames[layer]);
+    }
+    if (widths[layer] != widths[0] || heights[layer] != heights[0]) {
+      freePixels();
+      throw std::runtime_error("texture array layers differ in size: " + filenames[layer]);
+    }
   }
 
+  int texWidth = widths[0];
+  int texHeight = heights[0];
+  VkDeviceSize layerSize = texWidth * texHeight * 4;
+  VkDeviceSize imageSize = layerSize * layerCount;
+  mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
+
   VkBuffer stagingBuffer;
   VkDeviceMemory stagingBufferMemory;
 
@@ -88,26 +163,82 @@ void Image::createTextureImage(const std::string &filename) {
 
   void* data;
   vkMapMemory(xeDevice.device(), stagingBufferMemory, 0, imageSize, 0, &data);
-  memcpy(data, pixels, static_cast<size_t>(imageSize));
+  for (uint32_t layer = 0; layer < layerCount; layer++) {
+    memcpy(static_cast<stbi_uc*>(data) + layerSize * layer, pixels[layer], static_cast<size_t>(layerSize));
+  }
   vkUnmapMemory(xeDevice.device(), stagingBufferMemory);
 
-  stbi_image_free(pixels);
+  freePixels();
 
-  createImage(xeDevice, texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory);
+  createImage(xeDevice, texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, layerCount);
 
-  transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-  copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
+  VkCommandBuffer commandBuffer = xeDevice.beginSingleTimeCommands();
+  transitionImageLayout(commandBuffer, textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+  copyBufferToImage(commandBuffer, stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
+  generateMipmaps(commandBuffer, textureImage, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight, mipLevels);
+  xeDevice.endSingleTimeCommands(commandBuffer);
 
   vkDestroyBuffer(xeDevice.device(), stagingBuffer, nullptr);
   vkFreeMemory(xeDevice.device(), stagingBufferMemory, nullptr);
 
-  generateMipmaps(textureImage, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight, mipLevels);
-
 }
 
-void Image::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout) {
-    VkCommandBuffer commandBuffer = xeDevice.beginSingleTimeCommands();
+// Baked files already hold every mip level in the format they are sampled
+// in, so each level is copied straight in and nothing is blitted.
+void Image::createBakedTextureImage(const TextureFile &file) {
+  if (file.header.format == TextureFile::BC1 && !xeDevice.supportsTextureCompressionBC()) {
+    throw std::runtime_error("device does not support BC compressed textures");
+  }
+  mipLevels = file.header.mipLevels;
+  VkDeviceSize imageSize = file.data.size();
+
+  VkBuffer stagingBuffer;
+  VkDeviceMemory stagingBufferMemory;
 
+  xeDevice.createBuffer(
+    imageSize, 
+    VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
+    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
+    stagingBuffer, 
+    stagingBufferMemory
+  );
+
+  void* data;
+  vkMapMemory(xeDevice.device(), stagingBufferMemory, 0, imageSize, 0, &data);
+  memcpy(data, file.data.data(), static_cast<size_t>(imageSize));
+  vkUnmapMemory(xeDevice.device(), stagingBufferMemory);
+
+  createImage(xeDevice, file.header.width, file.header.height, mipLevels, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, layerCount);
+
+  std::vector<VkBufferImageCopy> regions(mipLevels);
+  for (uint32_t level = 0; level < mipLevels; level++) {
+    VkBufferImageCopy &region = regions[level];
+    region.bufferOffset = file.levelOffset(level);
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = level;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = layerCount;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {
+      TextureFile::mipExtent(file.header.width, level),
+      TextureFile::mipExtent(file.header.height, level),
+      1
+    };
+  }
+
+  VkCommandBuffer commandBuffer = xeDevice.beginSingleTimeCommands();
+  transitionImageLayout(commandBuffer, textureImage, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+  vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+  transitionImageLayout(commandBuffer, textureImage, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  xeDevice.endSingleTimeCommands(commandBuffer);
+
+  vkDestroyBuffer(xeDevice.device(), stagingBuffer, nullptr);
+  vkFreeMemory(xeDevice.device(), stagingBufferMemory, nullptr);
+}
+
+void Image::transitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout) {
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.oldLayout = oldLayout;
@@ -119,7 +250,7 @@ void Image::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout
     barrier.subresourceRange.baseMipLevel = 0;
     barrier.subresourceRange.levelCount = mipLevels;
     barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
+    barrier.subresourceRange.layerCount = layerCount;
 
     VkPipelineStageFlags sourceStage;
     VkPipelineStageFlags destinationStage;
@@ -148,13 +279,9 @@ void Image::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout
         0, nullptr,
         1, &barrier
     );
-
-    xeDevice.endSingleTimeCommands(commandBuffer);
 }
 
-void Image::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) {
-
-        VkCommandBuffer commandBuffer = xeDevice.beginSingleTimeCommands();
+void Image::generateMipmaps(VkCommandBuffer commandBuffer, VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) {
 
         VkImageMemoryBarrier barrier{};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -163,7 +290,7 @@ void Image::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidt
         barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
         barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
         barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount = 1;
+        barrier.subresourceRange.layerCount = layerCount;
         barrier.subresourceRange.levelCount = 1;
 
         int32_t mipWidth = texWidth;
@@ -188,13 +315,13 @@ void Image::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidt
             blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
             blit.srcSubresource.mipLevel = i - 1;
             blit.srcSubresource.baseArrayLayer = 0;
-            blit.srcSubresource.layerCount = 1;
+            blit.srcSubresource.layerCount = layerCount;
             blit.dstOffsets[0] = {0, 0, 0};
             blit.dstOffsets[1] = { mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 };
             blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
             blit.dstSubresource.mipLevel = i;
             blit.dstSubresource.baseArrayLayer = 0;
-            blit.dstSubresource.layerCount = 1;
+            blit.dstSubresource.layerCount = layerCount;
 
             vkCmdBlitImage(commandBuffer,
                 image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
@@ -228,13 +355,9 @@ void Image::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidt
             0, nullptr,
             0, nullptr,
             1, &barrier);
-
-        xeDevice.endSingleTimeCommands(commandBuffer);
     }
 
-void Image::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
-  VkCommandBuffer commandBuffer = xeDevice.beginSingleTimeCommands();
-  
+void Image::copyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
   VkBufferImageCopy region{};
   region.bufferOffset = 0;
   region.bufferRowLength = 0;
@@ -242,7 +365,7 @@ void Image::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, ui
   region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
   region.imageSubresource.mipLevel = 0;
   region.imageSubresource.baseArrayLayer = 0;
-  region.imageSubresource.layerCount = 1;
+  region.imageSubresource.layerCount = layerCount;
   region.imageOffset = {0, 0, 0};
   region.imageExtent = {
     width,
@@ -251,12 +374,10 @@ void Image::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, ui
   };
 
   vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-  xeDevice.endSingleTimeCommands(commandBuffer);
 }
 
 void Image::createTextureImageView() {
-    textureImageView = createImageView(xeDevice, textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
+    textureImageView = createImageView(xeDevice, textureImage, format, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, viewType, layerCount);
 }
 
 void Image::createTextureSampler(bool anisotropic) {
@@ -288,7 +409,7 @@ void Image::createTextureSampler(bool anisotropic) {
 //  STATIC CREATE IMAGE
 //
 
-void Image::createImage(Device& device, uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory) {
+void Image::createImage(Device& device, uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t arrayLayers) {
     
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -297,7 +418,7 @@ void Image::createImage(Device& device, uint32_t width, uint32_t height, uint32_
     imageInfo.extent.height = height;
     imageInfo.extent.depth = 1;
     imageInfo.mipLevels = mipLevels;
-    imageInfo.arrayLayers = 1;
+    imageInfo.arrayLayers = arrayLayers;
     imageInfo.format = format;
     imageInfo.tiling = tiling;
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -328,17 +449,17 @@ void Image::createImage(Device& device, uint32_t width, uint32_t height, uint32_
 //  STATIC CREATE IMAGE VIEW
 //
 
-VkImageView Image::createImageView(Device& device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) {
+VkImageView Image::createImageView(Device& device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels, VkImageViewType viewType, uint32_t layerCount) {
   VkImageViewCreateInfo viewInfo{};
   viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
   viewInfo.image = image;
-  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  viewInfo.viewType = viewType;
   viewInfo.format = format;
   viewInfo.subresourceRange.aspectMask = aspectFlags;
   viewInfo.subresourceRange.baseMipLevel = 0;
   viewInfo.subresourceRange.levelCount = mipLevels;
   viewInfo.subresourceRange.baseArrayLayer = 0;
-  viewInfo.subresourceRange.layerCount = 1;
+  viewInfo.subresourceRange.layerCount = layerCount;
 
   VkImageView imageView;
   if (vkCreateImageView(device.device(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "xe_device.hpp"
+#include "xe_texture_file.hpp"
 
 #include <string>
+#include <vector>
 #include <set>
 
 namespace xe {
@@ -12,6 +14,8 @@ class Image {
   public:
   
     static Image* createImage(const std::string &filename, bool anisotropic);
+    static Image* createImageArray(const std::vector<std::string> &filenames, bool anisotropic);
+    static Image* createBakedImageArray(const TextureFile &file, bool anisotropic);
     static void deleteImage(Image* image);
 
     ~Image();
@@ -23,21 +27,26 @@ class Image {
 
     static void submitDeleteQueue(bool purge);
 
-    Image(const std::string &filename, bool anisotropic);
+    Image(const std::vector<std::string> &filenames, bool array, bool anisotropic);
+    Image(const TextureFile &file, bool anisotropic);
 
-    void createTextureImage(const std::string &filename);
-    void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
-    void generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
-    void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+    void createTextureImage(const std::vector<std::string> &filenames);
+    void createBakedTextureImage(const TextureFile &file);
+    void transitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
+    void generateMipmaps(VkCommandBuffer commandBuffer, VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
+    void copyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
     void createTextureImageView();
     void createTextureSampler(bool anisotropic); 
 
-    static void createImage(Device& device, uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
-    static VkImageView createImageView(Device& device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
+    static void createImage(Device& device, uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t arrayLayers = 1);
+    static VkImageView createImageView(Device& device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels, VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D, uint32_t layerCount = 1);
 
     Device &xeDevice;
 
     uint32_t mipLevels;
+    uint32_t layerCount;
+    VkImageViewType viewType;
+    VkFormat format;
     VkSampler textureSampler;
     VkImage textureImage;
     VkImageView textureImageView;
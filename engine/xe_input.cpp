@@ -7,12 +7,14 @@ namespace xe {
 static Input* _instance;
 
 Input::Input(Window& window) : window{window} {
+  _instance = this;
+  if(window.isOffscreen()) return;
   glfwSetKeyCallback(window.getGLFWwindow(), Input::key_callback);
   glfwSetMouseButtonCallback(window.getGLFWwindow(), Input::mouse_callback);
-  _instance = this;
 }
 
 bool Input::isKeyPressed(int key) {
+  if(window.isOffscreen()) return false;
   return glfwGetKey(window.getGLFWwindow(), key) == GLFW_PRESS;
 }
 
@@ -1,5 +1,6 @@
 #include "xe_model.hpp"
 #include "xe_engine.hpp"
+#include "xe_trace.hpp"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "xe_obj_loader.hpp"
@@ -11,6 +12,9 @@
 #include <cstring>
 #include <unordered_map>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <atomic>
 
 namespace xe {
 
@@ -30,7 +34,10 @@ Model::~Model() {}
 //
 
 static std::set<Model*> CREATED_MODELS{};
-static std::set<Model*> DELETION_QUEUE{};
+static std::map<Model*, uint64_t> DELETION_QUEUE{};
+static std::mutex MODEL_LOCK{};
+static std::atomic<uint64_t> EPOCH{0};
+static std::atomic<uint64_t> FRAME_EPOCH{UINT64_MAX};
 
 Model* Model::createModel(const std::string &filepath) {
   Builder builder{};
@@ -39,30 +46,56 @@ Model* Model::createModel(const std::string &filepath) {
 }
 
 Model* Model::createModel(Builder& builder) {
+  XE_TRACE_SCOPE("Model::createModel");
   Model* model = new Model(builder);
+  std::lock_guard<std::mutex> lock(MODEL_LOCK);
   CREATED_MODELS.insert(model);
   return model;
 }
 
 void Model::deleteModel(Model* model) {
+  std::lock_guard<std::mutex> lock(MODEL_LOCK);
   if(CREATED_MODELS.count(model)) {
     CREATED_MODELS.erase(model);
-    DELETION_QUEUE.insert(model);
+    DELETION_QUEUE[model] = EPOCH;
   }
 }
 
+// When models are created and deleted on a different thread than the one
+// drawing, that thread advances the epoch each time it hands off a frame's
+// worth of draws. A model deleted in some epoch can still be referenced by
+// frames from that epoch, so it is only freed once the drawing thread has
+// moved on to a later one. Without a drawing thread everything is freed
+// straight away, as FRAME_EPOCH is never lowered.
+uint64_t Model::advanceEpoch() {
+  return ++EPOCH;
+}
+
+void Model::setFrameEpoch(uint64_t epoch) {
+  FRAME_EPOCH = epoch;
+}
+
 void Model::submitDeleteQueue(bool purge) {
-  if(DELETION_QUEUE.size() < 1) return;
-  vkDeviceWaitIdle(Engine::getInstance()->xeDevice.device());
-  for(Model* model: DELETION_QUEUE) {
-    try { delete model; } catch(int err) {};
-  }
-  DELETION_QUEUE.clear();
-  if (purge) {
-    for(Model* model: CREATED_MODELS) {
-      try { delete model; } catch(int err) {};
+  std::vector<Model*> deleted{};
+  {
+    std::lock_guard<std::mutex> lock(MODEL_LOCK);
+    for(auto it = DELETION_QUEUE.begin(); it != DELETION_QUEUE.end();) {
+      if(purge || it->second < FRAME_EPOCH) {
+        deleted.push_back(it->first);
+        it = DELETION_QUEUE.erase(it);
+      } else {
+        it++;
+      }
+    }
+    if (purge) {
+      deleted.insert(deleted.end(), CREATED_MODELS.begin(), CREATED_MODELS.end());
+      CREATED_MODELS.clear();
     }
-    CREATED_MODELS.clear();
+  }
+  if(deleted.size() < 1) return;
+  Engine::getInstance()->xeDevice.waitIdle();
+  for(Model* model: deleted) {
+    try { delete model; } catch(int err) {};
   }
 }
 
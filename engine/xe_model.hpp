@@ -38,6 +38,9 @@ class Model {
     static Model* createModel(Builder& builder);
     static void deleteModel(Model* model);
 
+    static uint64_t advanceEpoch();
+    static void setFrameEpoch(uint64_t epoch);
+
     ~Model();
 
     Model(const Model &) = delete;
@@ -115,7 +115,7 @@ namespace xe {
     pipelineInfo.basePipelineIndex = -1;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-    if(vkCreateGraphicsPipelines(xeDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS){
+    if(vkCreateGraphicsPipelines(xeDevice.device(), xeDevice.getPipelineCache(), 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS){
       throw std::runtime_error("failed to create graphics pipeline");
     }
   }
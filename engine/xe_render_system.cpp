@@ -1,5 +1,7 @@
 #include "xe_render_system.hpp"
 
+#include <algorithm>
+
 namespace xe {
 
 RenderSystem::RenderSystem(
@@ -25,21 +27,23 @@ RenderSystem::RenderSystem(
   createDescriptorSets();
   createPipelineLayout();
   createPipeline(xeRenderer.getSwapChainRenderPass(), vert, frag, cullingEnabled, wireframeEnabled, attributeDescptions, vertexSize);
+  createRecordingThreads();
 }
 
 RenderSystem::~RenderSystem() {
+  destroyRecordingThreads();
   vkDestroyPipelineLayout(xeDevice.device(), pipelineLayout, nullptr);
 };
 
 void RenderSystem::createDescriptorPool() {
   DescriptorPool::Builder builder{xeDevice};
-  builder.setMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT);
-  builder.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, uniformBindings.size() * SwapChain::MAX_FRAMES_IN_FLIGHT);
+  builder.setMaxSets(xeRenderer.getFramesInFlight());
+  builder.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, uniformBindings.size() * xeRenderer.getFramesInFlight());
   uint32_t images = imageBindings.size();
   for ( const auto &[binding, size]: imageArrayBindings) {
     images += size.size();
   }
-  builder.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, images * SwapChain::MAX_FRAMES_IN_FLIGHT);
+  builder.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, images * xeRenderer.getFramesInFlight());
   xeDescriptorPool = builder.build();
 }
 
@@ -63,12 +67,12 @@ void RenderSystem::createDescriptorSetLayout() {
 
 void RenderSystem::createUniformBuffers() {
   for ( const auto &[binding, bufferSize]: uniformBindings) {
-    uboBuffers[binding] = std::vector<std::unique_ptr<Buffer>>(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    uboBuffers[binding] = std::vector<std::unique_ptr<Buffer>>(xeRenderer.getFramesInFlight());
     for (int i = 0; i < uboBuffers[binding].size(); i++) {
       uboBuffers[binding][i] = std::make_unique<Buffer>(
         xeDevice,
         bufferSize,
-        SwapChain::MAX_FRAMES_IN_FLIGHT,
+        xeRenderer.getFramesInFlight(),
         VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
       uboBuffers[binding][i]->map();
@@ -78,7 +82,7 @@ void RenderSystem::createUniformBuffers() {
 
 void RenderSystem::createDescriptorSets() {
 
-  descriptorSets = std::vector<VkDescriptorSet>(SwapChain::MAX_FRAMES_IN_FLIGHT);
+  descriptorSets = std::vector<VkDescriptorSet>(xeRenderer.getFramesInFlight());
   for (int i = 0; i < descriptorSets.size(); i++) {
     updateDescriptorSet(i, true);
   }
@@ -179,6 +183,120 @@ void RenderSystem::createPipeline(VkRenderPass renderPass, std::string vert, std
   );
 }
 
+// Each recording thread owns a command pool, since a pool may only be used
+// from one thread at a time, with a secondary command buffer per frame in
+// flight. The threads sleep until renderParallel hands them a frame.
+void RenderSystem::createRecordingThreads() {
+  unsigned int threads = std::max(1u, std::min(std::thread::hardware_concurrency(), MAX_RECORDING_THREADS));
+  QueueFamilyIndices queueFamilyIndices = xeDevice.findPhysicalQueueFamilies();
+
+  recordingThreads.resize(threads);
+  for(int i = 0; i < recordingThreads.size(); i++) {
+    RecordingThread& thread = recordingThreads[i];
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    if(vkCreateCommandPool(xeDevice.device(), &poolInfo, nullptr, &thread.commandPool) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create recording command pool!");
+    }
+
+    thread.commandBuffers.resize(xeRenderer.getFramesInFlight());
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    allocInfo.commandPool = thread.commandPool;
+    allocInfo.commandBufferCount = static_cast<uint32_t>(thread.commandBuffers.size());
+    if(vkAllocateCommandBuffers(xeDevice.device(), &allocInfo, thread.commandBuffers.data()) != VK_SUCCESS) {
+      throw std::runtime_error("failed to allocate secondary command buffers!");
+    }
+
+    thread.recorded = false;
+    thread.worker = new std::thread([this, i]() {
+      uint64_t generation = 0;
+      std::unique_lock<std::mutex> lock(recordingLock);
+      while(true) {
+        recordingStart.wait(lock, [&]{ return recordingStopped || recordingGeneration != generation; });
+        if(recordingStopped) return;
+        generation = recordingGeneration;
+        lock.unlock();
+        std::exception_ptr error = nullptr;
+        try {
+          recordPartition(i);
+        } catch(...) {
+          error = std::current_exception();
+        }
+        lock.lock();
+        if(error != nullptr && recordingError == nullptr) recordingError = error;
+        if(--recordingPending == 0) recordingDone.notify_one();
+      }
+    });
+  }
+}
+
+void RenderSystem::destroyRecordingThreads() {
+  {
+    std::lock_guard<std::mutex> lock(recordingLock);
+    recordingStopped = true;
+  }
+  recordingStart.notify_all();
+  for(auto &thread : recordingThreads) {
+    thread.worker->join();
+    delete thread.worker;
+    vkDestroyCommandPool(xeDevice.device(), thread.commandPool, nullptr);
+  }
+  recordingThreads.clear();
+}
+
+void RenderSystem::recordPartition(int thread) {
+  size_t threads = recordingThreads.size();
+  size_t begin = recordingCount * thread / threads;
+  size_t end = recordingCount * (thread + 1) / threads;
+  recordingThreads[thread].recorded = begin < end;
+  if(begin >= end) return;
+
+  VkCommandBuffer commandBuffer = recordingThreads[thread].commandBuffers[xeRenderer.getFrameIndex()];
+
+  VkCommandBufferInheritanceInfo inheritanceInfo{};
+  inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritanceInfo.renderPass = xeRenderer.getSwapChainRenderPass();
+  inheritanceInfo.subpass = 0;
+  inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+  inheritanceInfo.pipelineStatistics = xeRenderer.getProfiler().getStatisticFlags();
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+  if(vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+    throw std::runtime_error("failed to begin recording secondary command buffer");
+  }
+
+  xePipeline->bind(commandBuffer);
+  xeRenderer.setViewport(commandBuffer);
+  if(descriptorSets.size() > 0) {
+    vkCmdBindDescriptorSets(
+        commandBuffer,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        pipelineLayout,
+        0,
+        1,
+        &descriptorSets[xeRenderer.getFrameIndex()],
+        0,
+        nullptr);
+  }
+
+  for(size_t i = begin; i < end; i++) {
+    (*recordingFunction)(commandBuffer, i);
+  }
+
+  if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+    throw std::runtime_error("failed to record secondary command buffer");
+  }
+}
+
 void RenderSystem::start() {
   xeRenderer.beginSwapChainRenderPass(xeRenderer.getCurrentCommandBuffer());
   xePipeline->bind(xeRenderer.getCurrentCommandBuffer());
@@ -197,9 +315,52 @@ void RenderSystem::start() {
   }
 }
 
+// Begins the render pass for drawing with renderParallel, which binds the
+// pipeline and descriptors in each secondary command buffer instead.
+void RenderSystem::startParallel() {
+  xeRenderer.beginSwapChainRenderPass(xeRenderer.getCurrentCommandBuffer(), VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+}
+
+// Splits count draws into one contiguous range per recording thread. Each
+// thread calls record for its range into its own secondary command buffer,
+// and the primary executes them in order once all have finished, so the draw
+// order is the same as recording them inline. The first exception thrown on a
+// recording thread is rethrown here once every thread is done.
+void RenderSystem::renderParallel(size_t count, const std::function<void(VkCommandBuffer, size_t)> &record) {
+  if(count == 0) return;
+  {
+    std::lock_guard<std::mutex> lock(recordingLock);
+    recordingCount = count;
+    recordingFunction = &record;
+    recordingPending = static_cast<int>(recordingThreads.size());
+    recordingGeneration++;
+  }
+  recordingStart.notify_all();
+  {
+    std::unique_lock<std::mutex> lock(recordingLock);
+    recordingDone.wait(lock, [&]{ return recordingPending == 0; });
+    recordingFunction = nullptr;
+    if(recordingError != nullptr) {
+      std::exception_ptr error = recordingError;
+      recordingError = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+  std::vector<VkCommandBuffer> commandBuffers{};
+  for(const auto &thread : recordingThreads) {
+    if(thread.recorded) commandBuffers.push_back(thread.commandBuffers[xeRenderer.getFrameIndex()]);
+  }
+  vkCmdExecuteCommands(xeRenderer.getCurrentCommandBuffer(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+}
+
 void RenderSystem::loadPushConstant(void *pushConstantData) {
+  loadPushConstant(xeRenderer.getCurrentCommandBuffer(), pushConstantData);
+}
+
+void RenderSystem::loadPushConstant(VkCommandBuffer commandBuffer, void *pushConstantData) {
   vkCmdPushConstants(
-        xeRenderer.getCurrentCommandBuffer(), 
+        commandBuffer, 
         pipelineLayout, 
         VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 
         0, 
@@ -222,11 +383,19 @@ void RenderSystem::loadTextureArray(uint32_t binding, std::vector<Image*>& image
 }
 
 void RenderSystem::render(GameObject &gameObject) {
+  render(gameObject.model);
+}
+
+void RenderSystem::render(Model *model) {
+  render(xeRenderer.getCurrentCommandBuffer(), model);
+}
+
+void RenderSystem::render(VkCommandBuffer commandBuffer, Model *model) {
 
-  if(gameObject.model == nullptr) return;
+  if(model == nullptr) return;
 
-  gameObject.model->bind(xeRenderer.getCurrentCommandBuffer());
-  gameObject.model->draw(xeRenderer.getCurrentCommandBuffer());
+  model->bind(commandBuffer);
+  model->draw(commandBuffer);
 
 }
 
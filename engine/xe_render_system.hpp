@@ -14,6 +14,11 @@
 #include <iostream>
 #include <map>
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
 
 namespace xe {
 
@@ -129,12 +134,19 @@ class RenderSystem {
     RenderSystem(const RenderSystem &) = delete;
     RenderSystem operator=(const RenderSystem &) = delete;
 
+    static constexpr unsigned int MAX_RECORDING_THREADS = 8;
+
     void start();
+    void startParallel();
+    void renderParallel(size_t count, const std::function<void(VkCommandBuffer, size_t)> &record);
     void loadPushConstant(void *pushConstantData);
+    void loadPushConstant(VkCommandBuffer commandBuffer, void *pushConstantData);
     void loadUniformObject(uint32_t binding, void *uniformBufferData);
     void loadTexture(uint32_t binding, Image *image);
     void loadTextureArray(uint32_t binding, std::vector<Image*> &images);
     void render(GameObject &gameObject);
+    void render(Model *model);
+    void render(VkCommandBuffer commandBuffer, Model *model);
     void stop();
 
   private:
@@ -146,6 +158,16 @@ class RenderSystem {
     void updateDescriptorSet(int frameIndex, bool allocate);
     void createPipelineLayout();
     void createPipeline(VkRenderPass renderPass, std::string vert, std::string frag, bool cullingEnabled, bool wireframeEnabled, std::vector<VkVertexInputAttributeDescription> attributeDescptions, uint32_t vertexSize);
+    void createRecordingThreads();
+    void destroyRecordingThreads();
+    void recordPartition(int thread);
+
+    struct RecordingThread {
+      VkCommandPool commandPool;
+      std::vector<VkCommandBuffer> commandBuffers;
+      std::thread* worker;
+      bool recorded;
+    };
 
     bool boundPipeline{false};
     bool boundDescriptor{false};
@@ -167,6 +189,17 @@ class RenderSystem {
     std::unique_ptr<DescriptorPool> xeDescriptorPool;
     std::unique_ptr<DescriptorSetLayout> xeDescriptorSetLayout;
 
+    std::vector<RecordingThread> recordingThreads{};
+    std::mutex recordingLock{};
+    std::condition_variable recordingStart{};
+    std::condition_variable recordingDone{};
+    uint64_t recordingGeneration{0};
+    int recordingPending{0};
+    bool recordingStopped{false};
+    size_t recordingCount{0};
+    const std::function<void(VkCommandBuffer, size_t)>* recordingFunction{nullptr};
+    std::exception_ptr recordingError{nullptr};
+
 };
 
 }
\ No newline at end of file
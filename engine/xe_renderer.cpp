@@ -1,28 +1,36 @@
 #include "xe_renderer.hpp"
+#include "xe_trace.hpp"
 
 namespace xe {
 
-Renderer::Renderer(Window& window, Device& device) : xeWindow{window}, xeDevice{device} {
-  recreateSwapChain();
+Renderer::Renderer(Window& window, Device& device, SwapChain::Config config) : xeWindow{window}, xeDevice{device}, config{config} {
+  while(!recreateSwapChain()) {
+    glfwWaitEvents();
+  }
   createCommandBuffers();
+  profiler = std::make_unique<GpuProfiler>(xeDevice, config.framesInFlight);
 }
 
 Renderer::~Renderer() { freeCommandBuffers(); }
 
-void Renderer::recreateSwapChain() { 
+// Frames may be drawn from a thread other than the one handling window
+// events, so a minimized window isn't waited out here. The swap chain is
+// left outdated and beginFrame skips frames until the window has a size again.
+bool Renderer::recreateSwapChain() { 
   auto extent = xeWindow.getExtent();
-  while (extent.width == 0 || extent.height == 0) {
-    extent = xeWindow.getExtent();
-    glfwWaitEvents();
+  if (extent.width == 0 || extent.height == 0) {
+    swapChainOutdated = true;
+    return false;
   }
+  swapChainOutdated = false;
 
-  vkDeviceWaitIdle(xeDevice.device());
+  xeDevice.waitIdle();
   
   if(xeSwapChain == nullptr) {
-    xeSwapChain = std::make_unique<SwapChain>(xeDevice, extent);
+    xeSwapChain = std::make_unique<SwapChain>(xeDevice, extent, config);
   } else {
     std::shared_ptr<SwapChain> oldSwapChain = std::move(xeSwapChain);
-    xeSwapChain = std::make_unique<SwapChain>(xeDevice, extent, oldSwapChain);
+    xeSwapChain = std::make_unique<SwapChain>(xeDevice, extent, config, oldSwapChain);
 
     if(!oldSwapChain->compareSwapFormats(*xeSwapChain.get())) {
       throw std::runtime_error("Swap chain image (or depth) format has changed");
@@ -30,12 +38,12 @@ void Renderer::recreateSwapChain() {
 
   }
 
-  // we'll come back to this in just a moment
+  return true;
 }
 
 void Renderer::createCommandBuffers() {
   
-  commandBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+  commandBuffers.resize(config.framesInFlight);
 
   VkCommandBufferAllocateInfo allocInfo{};
   allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -59,8 +67,13 @@ void Renderer::freeCommandBuffers() {
 }
 
 VkCommandBuffer Renderer::beginFrame() {
+  XE_TRACE_SCOPE("Renderer::beginFrame");
   assert(!isFrameStarted && "Can't call beingFrame while already in progress");
 
+  if(swapChainOutdated && !recreateSwapChain()) {
+    return nullptr;
+  }
+
   auto result = xeSwapChain->acquireNextImage(&currentImageIndex);
 
   if(result == VK_ERROR_OUT_OF_DATE_KHR) {
@@ -82,15 +95,23 @@ VkCommandBuffer Renderer::beginFrame() {
   if(vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
     throw std::runtime_error("failed to begin recording command buffers");
   }
+  recordStart = std::chrono::steady_clock::now();
+
+  profiler->beginFrame(commandBuffer, currentFrameIndex);
+  auto gpuResults = profiler->getResults();
+  FrameStats::add(FrameStats::GPU, gpuResults[RENDER_PASS_SCOPE]);
+
   return commandBuffer;
 }
 
 void Renderer::endFrame() {
+  XE_TRACE_SCOPE("Renderer::endFrame");
   assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
   auto commandBuffer = getCurrentCommandBuffer();
   if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
     throw std::runtime_error("failed to record command buffer");
   }
+  FrameStats::add(FrameStats::RECORD, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - recordStart).count());
 
   auto result = xeSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
   if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || xeWindow.wasWindowResized()) {
@@ -99,10 +120,10 @@ void Renderer::endFrame() {
   }
 
   isFrameStarted = false;
-  currentFrameIndex = (currentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+  currentFrameIndex = (currentFrameIndex + 1) % config.framesInFlight;
 }
 
-void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer){
+void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents){
   assert(isFrameStarted && "Can't call beginSwapChainRenderPass while frame is not in progress");
   assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from a different frame");
 
@@ -120,8 +141,18 @@ void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer){
   renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
   renderPassInfo.pClearValues = clearValues.data();
 
-  vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+  renderPassScope = profiler->beginScope(commandBuffer, RENDER_PASS_SCOPE);
+  profiler->beginStatistics(commandBuffer);
+  vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+
+  // A pass recorded in secondary command buffers sets its viewport in each
+  // of those instead, the primary may only execute them.
+  if(contents == VK_SUBPASS_CONTENTS_INLINE) {
+    setViewport(commandBuffer);
+  }
+}
 
+void Renderer::setViewport(VkCommandBuffer commandBuffer) {
   VkViewport viewport{};
   viewport.x = 0.0f;
   viewport.y = static_cast<float>(xeSwapChain->getSwapChainExtent().height);
@@ -139,7 +170,16 @@ void Renderer::endSwapChainRenderPass(VkCommandBuffer commandBuffer){
   assert(commandBuffer == getCurrentCommandBuffer() && "Can't end render pass on command buffer from a different frame");
 
   vkCmdEndRenderPass(commandBuffer);
+  profiler->endStatistics(commandBuffer);
+  profiler->endScope(commandBuffer, renderPassScope);
+
+}
 
+// Writes the last frame submitted to a PNG. Only offscreen frames can be
+// captured, presented images are handed back to the surface.
+void Renderer::captureFrame(const std::string &path) {
+  assert(!isFrameStarted && "Can't capture a frame while one is in progress");
+  xeSwapChain->captureImage(currentImageIndex, path);
 }
 
 }
\ No newline at end of file
@@ -4,18 +4,23 @@
 #include "xe_swap_chain.hpp"
 #include "xe_descriptors.hpp"
 #include "xe_window.hpp"
+#include "xe_gpu_profiler.hpp"
 
 #include <array>
 #include <cassert>
 #include <stdexcept>
 #include <memory>
+#include <chrono>
+#include <string>
 #include <vulkan/vulkan_core.h>
 
 namespace xe {
 class Renderer {
   public:
 
-    Renderer(Window &window, Device &device);
+    static constexpr const char* RENDER_PASS_SCOPE = "render pass";
+
+    Renderer(Window &window, Device &device, SwapChain::Config config);
     ~Renderer();
 
     Renderer(const Renderer &) = delete;
@@ -24,6 +29,8 @@ class Renderer {
     VkRenderPass getSwapChainRenderPass() const { return xeSwapChain->getRenderPass(); }
     float getAspectRatio() const { return xeSwapChain->extentAspectRatio(); }
     bool isFrameInProgress() const { return isFrameStarted; }
+    int getFramesInFlight() const { return config.framesInFlight; }
+    GpuProfiler& getProfiler() { return *profiler; }
 
     VkCommandBuffer getCurrentCommandBuffer() const { 
       assert(isFrameStarted && "Cannot get command buffer when frame not in progress");
@@ -37,21 +44,29 @@ class Renderer {
 
     VkCommandBuffer beginFrame();
     void endFrame();
-    void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+    void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+    void setViewport(VkCommandBuffer commandBuffer);
     void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
+    void captureFrame(const std::string &path);
 
   private:
     void createCommandBuffers();
     void freeCommandBuffers();
-    void recreateSwapChain();
+    bool recreateSwapChain();
 
     Window& xeWindow;
     Device& xeDevice;
+    SwapChain::Config config;
     std::unique_ptr<SwapChain> xeSwapChain;
     std::vector<VkCommandBuffer> commandBuffers;
 
     uint32_t currentImageIndex;
     int currentFrameIndex{0};
     bool isFrameStarted{false};
+    bool swapChainOutdated{false};
+    std::chrono::steady_clock::time_point recordStart{};
+
+    std::unique_ptr<GpuProfiler> profiler;
+    int renderPassScope{-1};
 };
 }
\ No newline at end of file
@@ -1,23 +1,32 @@
 #include "xe_swap_chain.hpp"
 
+#include "stb_image_write.h"
+
 namespace xe {
 
 bool SwapChain::initialSwapChainCreated = false;
 
-SwapChain::SwapChain(Device &deviceRef, VkExtent2D extent)
-    : device{deviceRef}, windowExtent{extent} {
+SwapChain::SwapChain(Device &deviceRef, VkExtent2D extent, Config config)
+    : device{deviceRef}, windowExtent{extent}, config{config} {
   init();
 }
 
-SwapChain::SwapChain(Device &deviceRef, VkExtent2D extent, std::shared_ptr<SwapChain> previous)
-    : device{deviceRef}, windowExtent{extent}, oldSwapChain{previous} {
+SwapChain::SwapChain(Device &deviceRef, VkExtent2D extent, Config config, std::shared_ptr<SwapChain> previous)
+    : device{deviceRef}, windowExtent{extent}, config{config}, oldSwapChain{previous} {
   init();
 
   oldSwapChain = nullptr;
 }
 
 void SwapChain::init() {
-  createSwapChain();
+  if (config.framesInFlight < 1 || config.framesInFlight > MAX_FRAMES_IN_FLIGHT) {
+    throw std::runtime_error("frames in flight must be between 1 and " + std::to_string(MAX_FRAMES_IN_FLIGHT));
+  }
+  if (config.offscreen) {
+    createOffscreenImages();
+  } else {
+    createSwapChain();
+  }
   createImageViews();
   createRenderPass();
   createColorResources();
@@ -38,6 +47,11 @@ SwapChain::~SwapChain() {
     swapChain = nullptr;
   }
 
+  for (int i = 0; i < offscreenImageMemorys.size(); i++) {
+    vkDestroyImage(device.device(), swapChainImages[i], nullptr);
+    vkFreeMemory(device.device(), offscreenImageMemorys[i], nullptr);
+  }
+
   for (int i = 0; i < colorImages.size(); i++) {
     vkDestroyImageView(device.device(), colorImageViews[i], nullptr);
     vkDestroyImage(device.device(), colorImages[i], nullptr);
@@ -56,7 +70,7 @@ SwapChain::~SwapChain() {
 
   vkDestroyRenderPass(device.device(), renderPass, nullptr);
 
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+  for (size_t i = 0; i < config.framesInFlight; i++) {
     vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
     vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
     vkDestroyFence(device.device(), inFlightFences[i], nullptr);
@@ -64,12 +78,22 @@ SwapChain::~SwapChain() {
 }
 
 VkResult SwapChain::acquireNextImage(uint32_t *imageIndex) {
-  vkWaitForFences(
-      device.device(),
-      1,
-      &inFlightFences[currentFrame],
-      VK_TRUE,
-      std::numeric_limits<uint64_t>::max());
+  {
+    FrameStats::Scope scope{FrameStats::FENCE_WAIT};
+    vkWaitForFences(
+        device.device(),
+        1,
+        &inFlightFences[currentFrame],
+        VK_TRUE,
+        std::numeric_limits<uint64_t>::max());
+  }
+
+  // Every frame in flight has its own offscreen image, and the fence above
+  // means the GPU is done with it.
+  if (config.offscreen) {
+    *imageIndex = static_cast<uint32_t>(currentFrame);
+    return VK_SUCCESS;
+  }
 
   VkResult result = vkAcquireNextImageKHR(
       device.device(),
@@ -85,6 +109,7 @@ VkResult SwapChain::acquireNextImage(uint32_t *imageIndex) {
 VkResult SwapChain::submitCommandBuffers(
     const VkCommandBuffer *buffers, uint32_t *imageIndex) {
   if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
+    FrameStats::Scope scope{FrameStats::FENCE_WAIT};
     vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
   }
 
@@ -96,9 +121,11 @@ VkResult SwapChain::submitCommandBuffers(
   VkSubmitInfo submitInfo = {};
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
+  // Nothing is acquired or presented offscreen, so there are no semaphores
+  // to wait on or signal.
   VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
   VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-  submitInfo.waitSemaphoreCount = 1;
+  submitInfo.waitSemaphoreCount = config.offscreen ? 0 : 1;
   submitInfo.pWaitSemaphores = waitSemaphores;
   submitInfo.pWaitDstStageMask = waitStages;
 
@@ -106,13 +133,23 @@ VkResult SwapChain::submitCommandBuffers(
   submitInfo.pCommandBuffers = buffers;
 
   VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-  submitInfo.signalSemaphoreCount = 1;
+  submitInfo.signalSemaphoreCount = config.offscreen ? 0 : 1;
   submitInfo.pSignalSemaphores = signalSemaphores;
 
+  std::lock_guard<std::mutex> lock(device.getQueueLock());
+
   vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-  if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-      VK_SUCCESS) {
-    throw std::runtime_error("failed to submit draw command buffer!");
+  {
+    FrameStats::Scope scope{FrameStats::SUBMIT};
+    if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
+        VK_SUCCESS) {
+      throw std::runtime_error("failed to submit draw command buffer!");
+    }
+  }
+
+  if (config.offscreen) {
+    currentFrame = (currentFrame + 1) % config.framesInFlight;
+    return VK_SUCCESS;
   }
 
   VkPresentInfoKHR presentInfo = {};
@@ -127,9 +164,13 @@ VkResult SwapChain::submitCommandBuffers(
 
   presentInfo.pImageIndices = imageIndex;
 
-  auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+  VkResult result;
+  {
+    FrameStats::Scope scope{FrameStats::PRESENT_WAIT};
+    result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+  }
 
-  currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+  currentFrame = (currentFrame + 1) % config.framesInFlight;
 
   return result;
 }
@@ -141,7 +182,7 @@ void SwapChain::createSwapChain() {
   VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
   VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-  uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+  uint32_t imageCount = std::max(swapChainSupport.capabilities.minImageCount + 1, static_cast<uint32_t>(config.framesInFlight));
   if (swapChainSupport.capabilities.maxImageCount > 0 &&
       imageCount > swapChainSupport.capabilities.maxImageCount) {
     imageCount = swapChainSupport.capabilities.maxImageCount;
@@ -191,6 +232,83 @@ void SwapChain::createSwapChain() {
   swapChainExtent = extent;
 }
 
+// B8G8R8A8 is the format most surfaces prefer, so offscreen frames are drawn
+// with the same pipelines and the same format as presented ones.
+void SwapChain::createOffscreenImages() {
+  swapChainImageFormat = VK_FORMAT_B8G8R8A8_UNORM;
+  swapChainExtent = windowExtent;
+
+  swapChainImages.resize(config.framesInFlight);
+  offscreenImageMemorys.resize(config.framesInFlight);
+  for (int i = 0; i < swapChainImages.size(); i++) {
+    Image::createImage(device, swapChainExtent.width, swapChainExtent.height, 1, VK_SAMPLE_COUNT_1_BIT, swapChainImageFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, swapChainImages[i], offscreenImageMemorys[i]);
+  }
+
+  if (!initialSwapChainCreated) {
+    std::cout << "Offscreen: " << swapChainExtent.width << "x" << swapChainExtent.height << std::endl;
+    std::cout << "Frames in flight: " << config.framesInFlight << std::endl;
+  }
+}
+
+// Copies a finished offscreen image back to the host and writes it as a PNG.
+// The copy is submitted after the frame that drew the image and waited on, so
+// this stalls the GPU and is only meant for occasional captures.
+void SwapChain::captureImage(uint32_t imageIndex, const std::string &path) {
+  if (!config.offscreen) {
+    throw std::runtime_error("only offscreen images can be captured");
+  }
+
+  VkDeviceSize imageSize = swapChainExtent.width * swapChainExtent.height * 4;
+  VkBuffer stagingBuffer;
+  VkDeviceMemory stagingBufferMemory;
+  device.createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+
+  VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = swapChainImages[imageIndex];
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = 1;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+  barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+  VkBufferImageCopy region{};
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.mipLevel = 0;
+  region.imageSubresource.baseArrayLayer = 0;
+  region.imageSubresource.layerCount = 1;
+  region.imageExtent = {swapChainExtent.width, swapChainExtent.height, 1};
+  vkCmdCopyImageToBuffer(commandBuffer, swapChainImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, stagingBuffer, 1, &region);
+
+  device.endSingleTimeCommands(commandBuffer);
+
+  std::vector<unsigned char> pixels(imageSize);
+  void* data;
+  vkMapMemory(device.device(), stagingBufferMemory, 0, imageSize, 0, &data);
+  memcpy(pixels.data(), data, static_cast<size_t>(imageSize));
+  vkUnmapMemory(device.device(), stagingBufferMemory);
+
+  vkDestroyBuffer(device.device(), stagingBuffer, nullptr);
+  vkFreeMemory(device.device(), stagingBufferMemory, nullptr);
+
+  for (size_t i = 0; i < pixels.size(); i += 4) {
+    std::swap(pixels[i], pixels[i + 2]);
+  }
+
+  if (!stbi_write_png(path.c_str(), swapChainExtent.width, swapChainExtent.height, 4, pixels.data(), swapChainExtent.width * 4)) {
+    throw std::runtime_error("failed to write capture: " + path);
+  }
+}
+
 void SwapChain::createImageViews() {
   swapChainImageViews.resize(swapChainImages.size());
   for (size_t i = 0; i < swapChainImages.size(); i++) {
@@ -250,7 +368,7 @@ void SwapChain::createRenderPass() {
   colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
   colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
   colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  colorAttachmentResolve.finalLayout = config.offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
   VkAttachmentReference colorAttachmentResolveRef{};
   colorAttachmentResolveRef.attachment = 2;
@@ -344,9 +462,9 @@ void SwapChain::createDepthResources() {
 }
 
 void SwapChain::createSyncObjects() {
-  imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-  renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-  inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+  imageAvailableSemaphores.resize(config.framesInFlight);
+  renderFinishedSemaphores.resize(config.framesInFlight);
+  inFlightFences.resize(config.framesInFlight);
   imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
 
   VkSemaphoreCreateInfo semaphoreInfo = {};
@@ -356,7 +474,7 @@ void SwapChain::createSyncObjects() {
   fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
   fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+  for (size_t i = 0; i < config.framesInFlight; i++) {
     if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
             VK_SUCCESS ||
         vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
@@ -381,25 +499,29 @@ VkSurfaceFormatKHR SwapChain::chooseSwapSurfaceFormat(
 
 VkPresentModeKHR SwapChain::chooseSwapPresentMode(
     const std::vector<VkPresentModeKHR> &availablePresentModes) {
+  VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
   for (const auto &availablePresentMode : availablePresentModes) {
-    if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-      if(!initialSwapChainCreated)
-        std::cout << "Present mode: Mailbox" << std::endl;
-      return availablePresentMode;
+    if (availablePresentMode == config.presentMode) {
+      presentMode = availablePresentMode;
     }
   }
 
-  for (const auto &availablePresentMode : availablePresentModes) {
-    if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-      if(!initialSwapChainCreated)
+  if(!initialSwapChainCreated) {
+    switch (presentMode) {
+      case VK_PRESENT_MODE_MAILBOX_KHR:
+        std::cout << "Present mode: Mailbox" << std::endl;
+        break;
+      case VK_PRESENT_MODE_IMMEDIATE_KHR:
         std::cout << "Present mode: Immediate" << std::endl;
-      return availablePresentMode;
+        break;
+      default:
+        std::cout << "Present mode: V-Sync" << std::endl;
+        break;
     }
+    std::cout << "Frames in flight: " << config.framesInFlight << std::endl;
   }
 
-  if(!initialSwapChainCreated)
-    std::cout << "Present mode: V-Sync" << std::endl;
-  return VK_PRESENT_MODE_FIFO_KHR;
+  return presentMode;
 }
 
 VkExtent2D SwapChain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities) {
@@ -3,6 +3,7 @@
 #include "xe_device.hpp"
 #include "xe_image.hpp"
 #include "xe_model.hpp"
+#include "xe_frame_stats.hpp"
 
 #include <vulkan/vulkan.h>
 
@@ -14,15 +15,26 @@
 #include <memory>
 #include <set>
 #include <stdexcept>
+#include <string>
 
 namespace xe {
 
 class SwapChain {
  public:
-  static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
-  SwapChain(Device &deviceRef, VkExtent2D windowExtent);
-  SwapChain(Device &deviceRef, VkExtent2D windowExtent, std::shared_ptr<SwapChain> previous);
+  static constexpr int MAX_FRAMES_IN_FLIGHT = 3;
+
+  // More frames in flight trade latency for throughput. The present mode
+  // falls back to FIFO, which every device supports, when it isn't available.
+  // Offscreen frames are drawn into plain device local images that are never
+  // presented, one per frame in flight, and can be captured to disk.
+  struct Config {
+    int framesInFlight = 2;
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+    bool offscreen = false;
+  };
+
+  SwapChain(Device &deviceRef, VkExtent2D windowExtent, Config config);
+  SwapChain(Device &deviceRef, VkExtent2D windowExtent, Config config, std::shared_ptr<SwapChain> previous);
   ~SwapChain();
 
   SwapChain(const SwapChain &) = delete;
@@ -36,6 +48,8 @@ class SwapChain {
   VkExtent2D getSwapChainExtent() { return swapChainExtent; }
   uint32_t width() { return swapChainExtent.width; }
   uint32_t height() { return swapChainExtent.height; }
+  int getFramesInFlight() const { return config.framesInFlight; }
+  bool isOffscreen() const { return config.offscreen; }
 
   float extentAspectRatio() {
     return static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height);
@@ -44,6 +58,7 @@ class SwapChain {
 
   VkResult acquireNextImage(uint32_t *imageIndex);
   VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+  void captureImage(uint32_t imageIndex, const std::string &path);
 
   bool compareSwapFormats(const SwapChain& swapChain) const {
     return swapChain.swapChainDepthFormat == swapChainDepthFormat &&
@@ -53,6 +68,7 @@ class SwapChain {
  private:
   void init();
   void createSwapChain();
+  void createOffscreenImages();
   void createImageViews();
   void createColorResources();
   void createDepthResources();
@@ -81,11 +97,13 @@ class SwapChain {
   std::vector<VkImageView> colorImageViews;
   std::vector<VkImage> swapChainImages;
   std::vector<VkImageView> swapChainImageViews;
+  std::vector<VkDeviceMemory> offscreenImageMemorys;
 
   Device &device;
   VkExtent2D windowExtent;
+  Config config;
 
-  VkSwapchainKHR swapChain;
+  VkSwapchainKHR swapChain = VK_NULL_HANDLE;
   std::shared_ptr<SwapChain> oldSwapChain;
 
   std::vector<VkSemaphore> imageAvailableSemaphores;
@@ -0,0 +1,130 @@
+#include "xe_texture_file.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+
+namespace xe {
+
+static constexpr uint32_t MAX_SOURCE_LENGTH = 4096;
+
+TextureFile TextureFile::read(const std::string& path) {
+  std::ifstream file{path, std::ios::ate | std::ios::binary};
+  if(!file.is_open()) {
+    throw std::runtime_error("failed to open texture file: " + path);
+  }
+  size_t size = static_cast<size_t>(file.tellg());
+  file.seekg(0);
+
+  TextureFile texture{};
+  if(size < sizeof(Header) || !file.read(reinterpret_cast<char*>(&texture.header), sizeof(Header))) {
+    throw std::runtime_error("texture file is too short: " + path);
+  }
+  const Header& header = texture.header;
+  if(header.magic != MAGIC || header.version != VERSION) {
+    throw std::runtime_error("not a version " + std::to_string(VERSION) + " texture file: " + path);
+  }
+  if(header.format != RGBA8 && header.format != BC1) {
+    throw std::runtime_error("unknown texture file format: " + path);
+  }
+  if(header.width == 0 || header.height == 0 || header.layers == 0 || header.mipLevels == 0) {
+    throw std::runtime_error("empty texture file: " + path);
+  }
+  if(header.mipLevels > MAX_MIP_LEVELS) {
+    throw std::runtime_error("too many mip levels in texture file: " + path);
+  }
+
+  size_t sourcesSize = 0;
+  for(uint32_t i = 0; i < header.sourceCount; i++) {
+    uint32_t length = 0;
+    if(!file.read(reinterpret_cast<char*>(&length), sizeof(length)) || length > MAX_SOURCE_LENGTH) {
+      throw std::runtime_error("bad source path in texture file: " + path);
+    }
+    std::string source(length, '\0');
+    if(!file.read(source.data(), length)) {
+      throw std::runtime_error("bad source path in texture file: " + path);
+    }
+    texture.sources.push_back(source);
+    sourcesSize += sizeof(length) + length;
+  }
+
+  size_t expected = texture.levelOffset(header.mipLevels);
+  if(size - sizeof(Header) - sourcesSize != expected) {
+    throw std::runtime_error("texture file size does not match its header: " + path);
+  }
+  texture.data.resize(expected);
+  file.read(reinterpret_cast<char*>(texture.data.data()), expected);
+  return texture;
+}
+
+void TextureFile::write(const std::string& path) const {
+  std::ofstream file{path, std::ios::binary};
+  if(!file.is_open()) {
+    throw std::runtime_error("failed to open texture file: " + path);
+  }
+  Header written = header;
+  written.sourceCount = static_cast<uint32_t>(sources.size());
+  file.write(reinterpret_cast<const char*>(&written), sizeof(Header));
+  for(const auto &source : sources) {
+    uint32_t length = static_cast<uint32_t>(source.size());
+    file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    file.write(source.data(), length);
+  }
+  file.write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+// FNV-1a over every path and the contents of its file, in order, so editing,
+// replacing or reordering any source changes the hash.
+uint64_t TextureFile::hashSources(const std::vector<std::string>& paths) {
+  uint64_t hash = 14695981039346656037ull;
+  auto add = [&](const char* bytes, size_t count) {
+    for(size_t i = 0; i < count; i++) {
+      hash = (hash ^ static_cast<unsigned char>(bytes[i])) * 1099511628211ull;
+    }
+  };
+  std::vector<char> contents{};
+  for(const auto &path : paths) {
+    std::ifstream file{path, std::ios::ate | std::ios::binary};
+    if(!file.is_open()) {
+      throw std::runtime_error("failed to open texture source: " + path);
+    }
+    contents.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(contents.data(), contents.size());
+    add(path.c_str(), path.size() + 1);
+    add(contents.data(), contents.size());
+  }
+  return hash;
+}
+
+// True when the file was baked from exactly these images, in this order, and
+// none of them have changed since.
+bool TextureFile::isBakedFrom(const std::vector<std::string>& paths) const {
+  return sources == paths && header.layers == paths.size() && header.sourceHash == hashSources(paths);
+}
+
+uint32_t TextureFile::mipExtent(uint32_t extent, uint32_t level) {
+  return std::max(extent >> level, 1u);
+}
+
+// Compressed levels smaller than a block still take up a whole block.
+size_t TextureFile::imageSize(Format format, uint32_t width, uint32_t height) {
+  if(format == BC1) {
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * 8;
+  }
+  return static_cast<size_t>(width) * height * 4;
+}
+
+size_t TextureFile::levelOffset(uint32_t level) const {
+  size_t offset = 0;
+  for(uint32_t i = 0; i < level; i++) {
+    offset += levelSize(i);
+  }
+  return offset;
+}
+
+size_t TextureFile::levelSize(uint32_t level) const {
+  return imageSize(static_cast<Format>(header.format), mipExtent(header.width, level), mipExtent(header.height, level)) * header.layers;
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace xe {
+
+// A texture baked ahead of time, with every mip level of every layer already
+// built and encoded. The file is the header, then the source image paths it
+// was baked from, then the data, one mip level after another from the
+// largest, each holding all of its layers, so a whole level uploads in one
+// copy. Nothing here depends on Vulkan, the bake tool uses it as well as
+// Image.
+class TextureFile {
+
+  public:
+
+    static constexpr uint32_t MAGIC = 0x58455458; // "XTEX"
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint32_t MAX_MIP_LEVELS = 32;
+
+    // RGBA8 is four bytes a pixel. BC1 is eight bytes per block of 4x4
+    // pixels, with one bit of alpha.
+    enum Format : uint32_t {
+      RGBA8 = 0,
+      BC1 = 1,
+    };
+
+    struct Header {
+      uint32_t magic;
+      uint32_t version;
+      uint32_t format;
+      uint32_t width;
+      uint32_t height;
+      uint32_t layers;
+      uint32_t mipLevels;
+      uint32_t sourceCount;
+      uint64_t sourceHash;
+    };
+
+    static TextureFile read(const std::string& path);
+    void write(const std::string& path) const;
+
+    static uint64_t hashSources(const std::vector<std::string>& paths);
+    bool isBakedFrom(const std::vector<std::string>& paths) const;
+
+    static uint32_t mipExtent(uint32_t extent, uint32_t level);
+    static size_t imageSize(Format format, uint32_t width, uint32_t height);
+
+    size_t levelOffset(uint32_t level) const;
+    size_t levelSize(uint32_t level) const;
+
+    Header header{};
+    std::vector<std::string> sources{};
+    std::vector<unsigned char> data{};
+
+};
+
+}
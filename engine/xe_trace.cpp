@@ -0,0 +1,117 @@
+#include "xe_trace.hpp"
+
+#include <array>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+
+namespace xe {
+
+// Every thread writes into its own ring buffer, so recording an event never
+// takes a lock. Chunk workers come and go constantly, so a buffer is handed
+// back when its thread exits and reused by the next one instead of every
+// thread getting its own. Events carry the id of the thread that wrote them.
+struct ThreadBuffer {
+  std::array<Trace::Event, Trace::BUFFER_SIZE> events{};
+  std::atomic<uint64_t> head{0};
+};
+
+static std::mutex BUFFERS_LOCK{};
+static std::vector<ThreadBuffer*> BUFFERS{};
+static std::vector<ThreadBuffer*> FREE_BUFFERS{};
+static std::atomic<uint32_t> NEXT_THREAD{1};
+static std::atomic<bool> ENABLED{false};
+
+struct ThreadSlot {
+  ThreadBuffer* buffer = nullptr;
+  uint32_t thread = 0;
+
+  ThreadBuffer* get() {
+    if(buffer != nullptr) return buffer;
+    thread = NEXT_THREAD++;
+    std::lock_guard<std::mutex> lock(BUFFERS_LOCK);
+    if(FREE_BUFFERS.empty()) {
+      buffer = new ThreadBuffer();
+      BUFFERS.push_back(buffer);
+    } else {
+      buffer = FREE_BUFFERS.back();
+      FREE_BUFFERS.pop_back();
+    }
+    return buffer;
+  }
+
+  ~ThreadSlot() {
+    if(buffer == nullptr) return;
+    std::lock_guard<std::mutex> lock(BUFFERS_LOCK);
+    FREE_BUFFERS.push_back(buffer);
+  }
+};
+
+static thread_local ThreadSlot SLOT{};
+
+void Trace::setEnabled(bool enabled) {
+  ENABLED = enabled;
+}
+
+bool Trace::isEnabled() {
+  return ENABLED.load(std::memory_order_relaxed);
+}
+
+uint64_t Trace::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::record(const char* name, uint64_t start, uint64_t end) {
+  ThreadBuffer* buffer = SLOT.get();
+  uint64_t head = buffer->head.load(std::memory_order_relaxed);
+  buffer->events[head % BUFFER_SIZE] = Event{name, start, end - start, SLOT.thread};
+  buffer->head.store(head + 1, std::memory_order_release);
+}
+
+// Writes the Chrome trace event format, which chrome://tracing and Perfetto
+// both open. Threads keep recording while this runs, so the oldest events of
+// a buffer that wraps around during the export may come out mixed up. Export
+// after disabling tracing to avoid it.
+void Trace::writeJson(const std::string& path) {
+  std::vector<Event> events{};
+  {
+    std::lock_guard<std::mutex> lock(BUFFERS_LOCK);
+    for(const auto buffer : BUFFERS) {
+      uint64_t head = buffer->head.load(std::memory_order_acquire);
+      uint64_t count = std::min<uint64_t>(head, BUFFER_SIZE);
+      for(uint64_t i = head - count; i < head; i++) {
+        events.push_back(buffer->events[i % BUFFER_SIZE]);
+      }
+    }
+  }
+
+  std::ofstream file{path};
+  if(!file.is_open()) {
+    throw std::runtime_error("failed to open trace file: " + path);
+  }
+
+  uint64_t origin = UINT64_MAX;
+  for(const auto &event : events) {
+    origin = std::min(origin, event.start);
+  }
+
+  file << std::fixed << std::setprecision(3);
+  file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  for(size_t i = 0; i < events.size(); i++) {
+    const Event& event = events[i];
+    if(i > 0) file << ",";
+    file << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1"
+         << ",\"tid\":" << event.thread
+         << ",\"ts\":" << (event.start - origin) / 1000.0
+         << ",\"dur\":" << event.duration / 1000.0 << "}";
+  }
+  file << "\n]}\n";
+}
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace xe {
+
+class Trace {
+
+  public:
+
+    static constexpr size_t BUFFER_SIZE = 16384;
+
+    struct Event {
+      const char* name;
+      uint64_t start;
+      uint64_t duration;
+      uint32_t thread;
+    };
+
+    class Scope {
+      public:
+        Scope(const char* name) : name{name}, start{isEnabled() ? now() : 0} {}
+        ~Scope() { if(start != 0) record(name, start, now()); }
+
+        Scope(const Scope&) = delete;
+        Scope operator=(const Scope&) = delete;
+
+      private:
+        const char* name;
+        uint64_t start;
+    };
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    static uint64_t now();
+    static void record(const char* name, uint64_t start, uint64_t end);
+    static void writeJson(const std::string& path);
+
+};
+
+}
+
+#define XE_TRACE_CONCAT_INNER(a, b) a##b
+#define XE_TRACE_CONCAT(a, b) XE_TRACE_CONCAT_INNER(a, b)
+#define XE_TRACE_SCOPE(name) xe::Trace::Scope XE_TRACE_CONCAT(traceScope, __LINE__){name}
@@ -3,12 +3,16 @@
 
 namespace xe {
 
-  Window::Window(int w, int h, std::string name, const char *icon) : width{w}, height{h}, windowName{name} {
+  // An offscreen window never touches GLFW, so it works without a display.
+  // It only holds the size frames are rendered at.
+  Window::Window(int w, int h, std::string name, const char *icon, bool offscreen) : width{w}, height{h}, windowName{name} {
+    if(offscreen) return;
     initWindow();
     setIcon(icon);
   }
 
   Window::~Window() {
+    if(window == nullptr) return;
     glfwDestroyWindow(window);
     glfwTerminate();
   }
@@ -7,22 +7,24 @@
 #include <GLFW/glfw3.h>
 #include <stdexcept>
 #include <string>
+#include <atomic>
 
 namespace xe {
     
 class Window {
   public:
-    Window(int w, int h, std::string name, const char *icon);
+    Window(int w, int h, std::string name, const char *icon, bool offscreen = false);
     ~Window();
 
     Window(const Window &) = delete;
     Window &operator=(const Window &);
 
-    bool shouldClose() { return glfwWindowShouldClose(window); }
+    bool shouldClose() { return window != nullptr && glfwWindowShouldClose(window); }
     VkExtent2D getExtent() { return { static_cast<uint32_t>(width), static_cast<uint32_t>(height)}; }
     bool wasWindowResized() { return frameBufferResized; }
     void resetWindowResizedFlag() { frameBufferResized = false; }
     GLFWwindow *getGLFWwindow() const { return window; }
+    bool isOffscreen() const { return window == nullptr; }
 
     void createWindowSurface(VkInstance instance, VkSurfaceKHR *surface);
 
@@ -31,12 +33,12 @@ class Window {
     void initWindow();  
     void setIcon(const char *icon);
     
-    int width;
-    int height;
-    bool frameBufferResized = false;
+    std::atomic<int> width;
+    std::atomic<int> height;
+    std::atomic<bool> frameBufferResized{false};
     
     std::string windowName;
-    GLFWwindow *window;
+    GLFWwindow *window = nullptr;
 
 };
  
@@ -3,11 +3,14 @@
 layout (location = 0) in float fragLight;
 layout (location = 1) in vec2 fragUv;
 layout (location = 2) in flat int fragTex;
+layout (location = 3) in float fragFog;
 
 layout (location = 0) out vec4 outColor;
 
-layout (binding = 1) uniform sampler2D texSampler[9];
+layout (binding = 1) uniform sampler2DArray texSampler;
+
+const vec4 FOG_COLOR = vec4(0.1, 0.1, 0.1, 1.0);
 
 void main() {
-  outColor = texture(texSampler[fragTex], fragUv) + fragLight;
+  outColor = mix(texture(texSampler, vec3(fragUv, fragTex)) + fragLight, FOG_COLOR, fragFog);
 }
\ No newline at end of file
@@ -8,10 +8,13 @@ layout (location = 3) in int tex;
 layout (location = 0) out float fragLight;
 layout (location = 1) out vec2 fragUv;
 layout (location = 2) out int fragTex;
+layout (location = 3) out float fragFog;
 
 layout (binding = 0) uniform GlobalUbo {
   mat4 projectionViewMatrix;
   vec3 directionToLight;
+  vec3 cameraPosition;
+  float fogDistance;
 } ubo;
 
 layout (push_constant) uniform Push {
@@ -20,10 +23,12 @@ layout (push_constant) uniform Push {
 } push;
 
 const float AMBIENT = 0.02;
+const float FOG_START = 0.75;
 
 void main() {
 
-  gl_Position = ubo.projectionViewMatrix * push.modelMatrix * vec4(position, 1.0);
+  vec4 worldPosition = push.modelMatrix * vec4(position, 1.0);
+  gl_Position = ubo.projectionViewMatrix * worldPosition;
   vec3 normalWorldSpace = normalize(mat3(push.normalMatrix) * normal);
 
   float lightIntensity = AMBIENT + max(dot(normalWorldSpace, ubo.directionToLight), 0);
@@ -31,4 +36,11 @@ void main() {
   fragLight = lightIntensity / 5;
   fragUv = uv;
   fragTex = tex;
+
+  if (ubo.fogDistance > 0) {
+    float viewDistance = length(worldPosition.xz - ubo.cameraPosition.xz);
+    fragFog = clamp((viewDistance / ubo.fogDistance - FOG_START) / (1 - FOG_START), 0, 1);
+  } else {
+    fragFog = 0;
+  }
 }
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "camera_path.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace app {
+
+// One step per line, the translation then the rotation, six numbers in all.
+CameraPath CameraPath::load(const std::string& path) {
+  std::ifstream file{path};
+  if(!file.is_open()) {
+    throw std::runtime_error("failed to open camera path: " + path);
+  }
+  CameraPath cameraPath{};
+  Step step{};
+  while(file >> step.translation.x >> step.translation.y >> step.translation.z
+             >> step.rotation.x >> step.rotation.y >> step.rotation.z) {
+    cameraPath.steps.push_back(step);
+  }
+  if(!file.eof()) {
+    throw std::runtime_error("malformed camera path: " + path);
+  }
+  return cameraPath;
+}
+
+// Flies level at a constant speed while turning at a constant rate, which
+// sweeps the view across new terrain on every step.
+CameraPath CameraPath::curve(glm::vec3 start, float yaw, float speed, float turnRate, float timestep, int steps) {
+  CameraPath cameraPath{};
+  Step step{start, {0.f, yaw, 0.f}};
+  for(int i = 0; i < steps; i++) {
+    step.rotation.y += turnRate * timestep;
+    step.translation += glm::vec3{sin(step.rotation.y), 0.f, cos(step.rotation.y)} * speed * timestep;
+    cameraPath.steps.push_back(step);
+  }
+  return cameraPath;
+}
+
+void CameraPath::record(const xe::TransformComponent& transform) {
+  steps.push_back({transform.translation, transform.rotation});
+}
+
+void CameraPath::save(const std::string& path) const {
+  std::ofstream file{path};
+  if(!file.is_open()) {
+    throw std::runtime_error("failed to open camera path: " + path);
+  }
+  file.precision(9);
+  for(const auto &step : steps) {
+    file << step.translation.x << " " << step.translation.y << " " << step.translation.z << " "
+         << step.rotation.x << " " << step.rotation.y << " " << step.rotation.z << "\n";
+  }
+}
+
+// Returns false once the path has run out, leaving the transform as it was.
+bool CameraPath::sample(int step, xe::TransformComponent& transform) const {
+  if(step < 0 || step >= size()) return false;
+  transform.translation = steps[step].translation;
+  transform.rotation = steps[step].rotation;
+  return true;
+}
+
+}
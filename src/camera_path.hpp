@@ -0,0 +1,42 @@
+#pragma once
+
+#include "xe_game_object.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/common.hpp>
+#include <glm/fwd.hpp>
+
+#include <vector>
+#include <string>
+
+namespace app {
+
+// A camera position for every step of a fixed timestep, either recorded from
+// play or built from a formula. Replaying one drives the viewer exactly the
+// same way on every run, whatever the frame rate.
+class CameraPath {
+
+  public:
+
+    static CameraPath load(const std::string& path);
+    static CameraPath curve(glm::vec3 start, float yaw, float speed, float turnRate, float timestep, int steps);
+
+    void record(const xe::TransformComponent& transform);
+    void save(const std::string& path) const;
+    void clear() { steps.clear(); }
+
+    bool sample(int step, xe::TransformComponent& transform) const;
+    int size() const { return static_cast<int>(steps.size()); }
+
+  private:
+
+    struct Step {
+      glm::vec3 translation;
+      glm::vec3 rotation;
+    };
+
+    std::vector<Step> steps{};
+
+};
+
+}
@@ -0,0 +1,91 @@
+#include "chunk_models.hpp"
+
+#include <map>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+namespace app {
+
+static std::map<std::pair<int32_t, int32_t>, xe::Model*> models{};
+static xe::Image* texture = nullptr;
+static uint32_t uploadCount = 0;
+
+//
+//  CHUNK TEXTURE LOADING
+//
+
+static const std::string BAKED_TEXTURES = "res/image/blocks.xtex";
+
+// Has to run after Chunk::load, which decides the texture paths and their
+// order. Every block texture is one layer of a single array image, and the
+// texture id in the vertex data is the layer it samples. The textures made by
+// `make bake` are used when they were baked from exactly the current PNGs,
+// otherwise the PNGs are loaded and mipmapped here instead.
+void ChunkModels::load() {
+  const auto &paths = Chunk::getTexturePaths();
+  if(std::filesystem::exists(BAKED_TEXTURES)) {
+    try {
+      xe::TextureFile file = xe::TextureFile::read(BAKED_TEXTURES);
+      if(file.isBakedFrom(paths)) {
+        texture = xe::Image::createBakedImageArray(file, false);
+      } else {
+        std::cout << "Baked textures not used: " << BAKED_TEXTURES << " is out of date, run make bake" << std::endl;
+      }
+    } catch(const std::runtime_error &e) {
+      std::cout << "Baked textures not used: " << e.what() << std::endl;
+    }
+  }
+  if(texture == nullptr) {
+    texture = xe::Image::createImageArray(paths, false);
+  }
+}
+
+void ChunkModels::unload() {
+  for(const auto &[key, model] : models) {
+    xe::Model::deleteModel(model);
+  }
+  models.clear();
+  xe::Image::deleteImage(texture);
+  texture = nullptr;
+}
+
+xe::Image* ChunkModels::getTexture() {
+  return texture;
+}
+
+//
+//  CHUNK MODEL UPLOADING
+//
+
+// Uploads the newest mesh of the chunk if it has one and returns the model to
+// draw, which stays the previous one until a new mesh is finished.
+xe::Model* ChunkModels::update(Chunk* chunk) {
+  auto &model = models[{chunk->gridX, chunk->gridZ}];
+  xe::Model::Builder builder{};
+  if(chunk->takeMesh(builder.vertexData.data)) {
+    if(model != nullptr) {
+      xe::Model::deleteModel(model);
+    }
+    builder.vertexSize = ChunkMesher::VERTEX_SIZE;
+    model = xe::Model::createModel(builder);
+    uploadCount++;
+  }
+  return model;
+}
+
+// Models uploaded since the last call.
+uint32_t ChunkModels::takeUploadCount() {
+  uint32_t count = uploadCount;
+  uploadCount = 0;
+  return count;
+}
+
+void ChunkModels::remove(int32_t gridX, int32_t gridZ) {
+  auto it = models.find({gridX, gridZ});
+  if(it == models.end()) return;
+  xe::Model::deleteModel(it->second);
+  models.erase(it);
+}
+
+}
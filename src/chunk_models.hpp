@@ -0,0 +1,29 @@
+#pragma once
+
+#include "xe_model.hpp"
+#include "xe_image.hpp"
+
+#include "chunk.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace app {
+
+// Turns the CPU meshes built by Chunk into GPU models, and loads the block
+// textures they refer to. Nothing in Chunk itself touches the engine.
+class ChunkModels {
+
+  public:
+
+    static void load();
+    static void unload();
+    static xe::Image* getTexture();
+
+    static xe::Model* update(Chunk* chunk);
+    static void remove(int32_t gridX, int32_t gridZ);
+    static uint32_t takeUploadCount();
+
+};
+
+}
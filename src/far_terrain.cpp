@@ -0,0 +1,178 @@
+#include "far_terrain.hpp"
+
+#include <glm/geometric.hpp>
+#include <cmath>
+#include <algorithm>
+
+namespace app {
+
+//
+//  FAR TERRAIN CONSTRUCTORS AND DECONSTUCTORS
+//
+
+FarTerrain::FarTerrain(uint32_t worldSeed)
+  : worldSeed{worldSeed},
+    object{xe::GameObject::createGameObject()} {
+  mesh = nullptr;
+  worker = nullptr;
+  finished = false;
+}
+
+FarTerrain::~FarTerrain() {
+  resetThread();
+  if(mesh != nullptr) {
+    xe::Model::deleteModel(mesh);
+  }
+}
+
+void FarTerrain::resetThread() {
+  if(worker != nullptr && worker->joinable()) {
+    worker->join();
+  }
+  delete worker;
+  worker = nullptr;
+}
+
+//
+//  FAR TERRAIN UPDATING
+//
+
+// The horizon is rebuilt around the view whenever it drifts REBUILD_DISTANCE
+// blocks from the last build or the voxel radius it has to surround changes.
+// The previous grid keeps drawing until the new one is finished.
+void FarTerrain::update(glm::vec3 viewPosition, int newInnerRadius) {
+  if(worker != nullptr) {
+    if(!finished) return;
+    resetThread();
+    if(mesh != nullptr) {
+      xe::Model::deleteModel(mesh);
+    }
+    mesh = builder.indices.empty() ? nullptr : xe::Model::createModel(builder);
+    builder.vertexData.data.clear();
+    builder.indices.clear();
+    object.model = mesh;
+    object.transform.translation = glm::vec3(origin.x, -1.f, origin.y);
+    return;
+  }
+
+  glm::ivec2 center{
+    static_cast<int>(floor(viewPosition.x / CELL_SIZE)) * CELL_SIZE,
+    static_cast<int>(floor(viewPosition.z / CELL_SIZE)) * CELL_SIZE
+  };
+  if(built && newInnerRadius == innerRadius &&
+     abs(center.x - origin.x) < REBUILD_DISTANCE &&
+     abs(center.y - origin.y) < REBUILD_DISTANCE) {
+    return;
+  }
+
+  origin = center;
+  innerRadius = newInnerRadius;
+  built = true;
+  finished = false;
+  worker = new std::thread(build, this);
+}
+
+//
+//  FAR TERRAIN MESHING
+//
+
+// Samples only the column height and surface block from the terrain functions
+// once per cell corner, so a grid thousands of blocks across costs less than a
+// single voxel chunk. Cells well inside the voxel terrain are left out and the
+// whole grid sits a block lower so real chunks always win where they overlap.
+// The view can drift from the grid origin until the next rebuild, so there is
+// a ring where loaded chunks may or may not cover the grid. There the surface
+// between the corners is sampled too, and corners are pushed down by however
+// far the interpolated cells rise above it, so no hill pokes through.
+void FarTerrain::build(FarTerrain* t) {
+  const PerlinNoise perlin{t->worldSeed};
+  const int size = GRID_SIZE + 1;
+  const int half = GRID_SIZE / 2;
+
+  std::vector<int> heights(size * size);
+  std::vector<uint8_t> surface(size * size);
+  for(int j = 0; j < size; j++) {
+    for(int i = 0; i < size; i++) {
+      int x = t->origin.x + (i - half) * CELL_SIZE;
+      int z = t->origin.y + (j - half) * CELL_SIZE;
+      ChunkTerrain::sampleSurface(perlin, x, z, heights[i + j * size], surface[i + j * size]);
+    }
+  }
+
+  auto height = [&](int i, int j) {
+    return heights[std::clamp(i, 0, size - 1) + std::clamp(j, 0, size - 1) * size];
+  };
+
+  const float diagonal = CELL_SIZE * 0.7071f;
+  const float skip = t->innerRadius - REBUILD_DISTANCE;
+  const float overlap = t->innerRadius + REBUILD_DISTANCE * 1.4143f + Chunk::CHUNK_SIZE.x;
+  auto cellDistance = [&](int i, int j) {
+    return glm::length(glm::vec2(i - half + 0.5f, j - half + 0.5f)) * CELL_SIZE;
+  };
+
+  std::vector<float> drops(size * size, 0.f);
+  for(int j = 0; j < GRID_SIZE; j++) {
+    for(int i = 0; i < GRID_SIZE; i++) {
+      float distance = cellDistance(i, j);
+      if(distance + diagonal < skip || distance - diagonal > overlap) continue;
+      // Matches the split of the cell into triangles a b c and c d a below.
+      float a = height(i, j), b = height(i, j + 1), c = height(i + 1, j + 1), d = height(i + 1, j);
+      float excess = 0.f;
+      for(int v = 0; v <= CELL_SIZE; v += ERROR_SAMPLE_STEP) {
+        for(int u = 0; u <= CELL_SIZE; u += ERROR_SAMPLE_STEP) {
+          float fu = static_cast<float>(u) / CELL_SIZE;
+          float fv = static_cast<float>(v) / CELL_SIZE;
+          float interpolated = fv >= fu
+            ? a + fu * (c - b) + fv * (b - a)
+            : a + fu * (d - a) + fv * (c - d);
+          int actual;
+          uint8_t block;
+          ChunkTerrain::sampleSurface(perlin, t->origin.x + (i - half) * CELL_SIZE + u, t->origin.y + (j - half) * CELL_SIZE + v, actual, block);
+          excess = std::max(excess, interpolated - actual);
+        }
+      }
+      for(const int corner : {i + j * size, i + (j + 1) * size, (i + 1) + (j + 1) * size, (i + 1) + j * size}) {
+        drops[corner] = std::max(drops[corner], excess);
+      }
+    }
+  }
+
+  xe::Model::Data& data = t->builder.vertexData;
+  data.data.reserve(size * size * 36);
+  for(int j = 0; j < size; j++) {
+    for(int i = 0; i < size; i++) {
+      glm::vec3 normal = glm::normalize(glm::vec3(
+        height(i - 1, j) - height(i + 1, j),
+        2.f * CELL_SIZE,
+        height(i, j - 1) - height(i, j + 1)
+      ));
+      data.write<float>((i - half) * CELL_SIZE);
+      data.write<float>(height(i, j) - drops[i + j * size]);
+      data.write<float>((j - half) * CELL_SIZE);
+      data.write<float>(normal.x);
+      data.write<float>(normal.y);
+      data.write<float>(normal.z);
+      data.write<float>(i);
+      data.write<float>(j);
+      data.write<uint32_t>(Chunk::getFaceTexture(surface[i + j * size], 2));
+    }
+  }
+
+  std::vector<uint32_t>& indices = t->builder.indices;
+  for(int j = 0; j < GRID_SIZE; j++) {
+    for(int i = 0; i < GRID_SIZE; i++) {
+      float distance = cellDistance(i, j);
+      if(distance + diagonal < skip || distance - diagonal > RADIUS) continue;
+      uint32_t a = i + j * size;
+      uint32_t b = i + (j + 1) * size;
+      uint32_t c = (i + 1) + (j + 1) * size;
+      uint32_t d = (i + 1) + j * size;
+      indices.insert(indices.end(), {a, b, c, c, d, a});
+    }
+  }
+
+  t->builder.vertexSize = 36;
+  t->finished = true;
+}
+
+}
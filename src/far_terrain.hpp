@@ -0,0 +1,56 @@
+#pragma once
+
+#include "xe_game_object.hpp"
+#include "xe_model.hpp"
+
+#include "chunk.hpp"
+
+#include <glm/common.hpp>
+#include <glm/fwd.hpp>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+namespace app {
+
+class FarTerrain {
+
+  public:
+
+    static constexpr int CELL_SIZE = 16;
+    static constexpr int GRID_SIZE = 192;
+    static constexpr int RADIUS = CELL_SIZE * GRID_SIZE / 2;
+    static constexpr int REBUILD_DISTANCE = 64;
+    static constexpr int ERROR_SAMPLE_STEP = 2;
+
+    FarTerrain(uint32_t worldSeed);
+    ~FarTerrain();
+
+    FarTerrain(const FarTerrain&) = delete;
+    FarTerrain operator=(const FarTerrain&) = delete;
+
+    void update(glm::vec3 viewPosition, int innerRadius);
+
+    xe::GameObject& getObject() { return object; }
+
+  private:
+
+    static void build(FarTerrain* t);
+
+    void resetThread();
+
+    const uint32_t worldSeed;
+
+    glm::ivec2 origin{0};
+    int innerRadius{-1};
+    bool built{false};
+
+    xe::GameObject object;
+    xe::Model* mesh;
+    xe::Model::Builder builder{};
+    std::thread* worker;
+    std::atomic<bool> finished;
+
+};
+
+}
@@ -1,18 +1,71 @@
 #include "minecraft.hpp"
 
 #include <cstdlib>
+#include <cstring>
+#include <string>
 #include <iostream>
 #include <stdexcept>
 
-int main() {
-    app::Minecraft app{};
+static VkPresentModeKHR parsePresentMode(const char* name) {
+    if(strcmp(name, "fifo") == 0) return VK_PRESENT_MODE_FIFO_KHR;
+    if(strcmp(name, "mailbox") == 0) return VK_PRESENT_MODE_MAILBOX_KHR;
+    if(strcmp(name, "immediate") == 0) return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    throw std::runtime_error(std::string("unknown present mode: ") + name);
+}
+
+// Usage: game [--frames-in-flight n] [--present-mode fifo|mailbox|immediate]
+//             [--offscreen [frames] [capture interval] | --replay [camera path]]
+// A replay without a camera path flies a fixed curve instead. A present mode
+// the device does not support falls back to fifo.
+int main(int argc, char **argv) {
+    xe::SwapChain::Config config{app::Minecraft::FRAMES_IN_FLIGHT, app::Minecraft::PRESENT_MODE, false};
+    bool replay = false;
+    int frames = app::Minecraft::OFFSCREEN_FRAMES;
+    int captureInterval = 0;
+    const char* replayPath = nullptr;
+
+    try {
+        for(int i = 1; i < argc; i++) {
+            if(strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc) {
+                config.framesInFlight = atoi(argv[++i]);
+                if(config.framesInFlight < 1 || config.framesInFlight > xe::SwapChain::MAX_FRAMES_IN_FLIGHT) {
+                    throw std::runtime_error("frames in flight must be between 1 and " + std::to_string(xe::SwapChain::MAX_FRAMES_IN_FLIGHT));
+                }
+            } else if(strcmp(argv[i], "--present-mode") == 0 && i + 1 < argc) {
+                config.presentMode = parsePresentMode(argv[++i]);
+            } else if(strcmp(argv[i], "--offscreen") == 0) {
+                config.offscreen = true;
+                if(i + 1 < argc && argv[i + 1][0] != '-') frames = atoi(argv[++i]);
+                if(i + 1 < argc && argv[i + 1][0] != '-') captureInterval = atoi(argv[++i]);
+            } else if(strcmp(argv[i], "--replay") == 0) {
+                replay = true;
+                if(i + 1 < argc && argv[i + 1][0] != '-') replayPath = argv[++i];
+            } else {
+                throw std::runtime_error(std::string("unknown argument: ") + argv[i]);
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    app::Minecraft app{config};
 
     try {
-        app.run();
+        if(config.offscreen) {
+            app.runOffscreen(frames, captureInterval);
+        } else if(replay) {
+            const app::CameraPath path = replayPath != nullptr
+                ? app::CameraPath::load(replayPath)
+                : app::Minecraft::defaultPath(1.f / app::Minecraft::TICK_RATE, app::Minecraft::REPLAY_TICKS);
+            app.run(&path);
+        } else {
+            app.run();
+        }
     } catch (const std::exception &e) {
         std::cerr << e.what() << '\n';
         return EXIT_FAILURE;
     }
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -1,47 +1,279 @@
 #include "minecraft.hpp"
 
 #include <chrono>
+#include <fstream>
+#include <mutex>
+#include <thread>
 using namespace std::chrono;
 
 namespace app {
 
-Minecraft::Minecraft() : engine{WIDTH, HEIGHT, "Minecraft Vulkan", "res/image/icon.png"} {};
+Minecraft::Minecraft(xe::SwapChain::Config config) : engine{WIDTH, HEIGHT, "Minecraft Vulkan", "res/image/icon.png", config} {};
 
 Minecraft::~Minecraft() {}
 
-void Minecraft::run() {
+// Loads the chunk state both runs share, spawns the viewer and the world
+// around it and hands them to body. World unloads its chunks into the cache
+// when it goes out of scope, so it has to be gone before the chunks and their
+// models are unloaded.
+void Minecraft::withWorld(const std::function<void(xe::GameObject& viewer, World& world)>& body) {
 
   Chunk::load();
+  ChunkModels::load();
+  ChunkCache::setBudget(ChunkCache::DEFAULT_BUDGET_MB);
+  ChunkCache::setMeshCaching(true);
+  engine.setFarPlane(FarTerrain::RADIUS * 1.5f);
 
-  auto viewer = xe::GameObject::createGameObject();
-  viewer.transform.translation = {0.f, 40.f, 0.f};
-  viewer.transform.rotation.y = glm::radians(45.f);
+  {
+    auto viewer = xe::GameObject::createGameObject();
+    viewer.transform.translation = {0.f, 40.f, 0.f};
+    viewer.transform.rotation.y = glm::radians(45.f);
 
-  World world {viewer, 10, 12345};
+    World world {viewer, 10, WORLD_SEED};
 
-  xe::Sound sound{"res/sound/when_the_world_ends.wav"};
-  sound.setLooping(true);
-  sound.play();
+    body(viewer, world);
+  }
+
+  Chunk::unload();
+  ChunkModels::unload();
+
+}
+
+// With a replay the viewer follows the path one step per tick instead of the
+// keyboard, and the run ends when the path does, writing what every tick did
+// to REPLAY_METRICS_PATH. F5 records the path flown to RECORDED_PATH.
+void Minecraft::run(const CameraPath* replay) {
+  withWorld([&](xe::GameObject& viewer, World& world) {
+    xe::FrameStats::keepAll(replay != nullptr);
+
+    xe::Sound sound{"res/sound/when_the_world_ends.wav"};
+    sound.setLooping(true);
+    sound.play();
     
-  PlayerController playerController{engine.getInput(), viewer};
+    PlayerController playerController{engine.getInput(), viewer};
+
+    // Movement and chunk bookkeeping run at a fixed TICK_RATE on this thread.
+    // Each tick ends by handing a snapshot of what to draw to the render thread,
+    // which draws as fast as it can, placing the view between the last two ticks
+    // by how long ago the newest one was taken. After a long stall at most
+    // MAX_CATCH_UP_TICKS are run and the rest of the backlog is dropped instead
+    // of trying to catch up on all of it.
+    const float tickTime = 1.f / TICK_RATE;
+    float accumulator = 0.f;
 
-  while (engine.poll()) {
+    std::mutex snapshotLock{};
+    FrameSnapshot building{};
+    FrameSnapshot published{};
+    FrameSnapshot drawing{};
+    bool hasSnapshot = false;
+    size_t drawn = 0;
 
-    playerController.update(engine.getFrameTime());
+    auto publish = [&]() {
+      building.previousView = playerController.previous;
+      building.view = viewer.transform;
+      building.tickTime = steady_clock::now();
+      world.snapshot(building);
+      drawn = building.draws.size();
+      building.epoch = xe::Model::advanceEpoch();
+      std::lock_guard<std::mutex> lock(snapshotLock);
+      std::swap(building, published);
+      hasSnapshot = true;
+    };
 
-    world.reloadChunks();
+    publish();
 
-    if(engine.beginFrame()) {
-      world.render(engine.getCamera());
+    int tick = 0;
+    bool replayFinished = false;
+    std::vector<TickMetrics> metrics{};
+    bool recording = false;
+    CameraPath recorded{};
+
+    engine.startRenderThread([&]() {
+      {
+        std::lock_guard<std::mutex> lock(snapshotLock);
+        if(hasSnapshot) {
+          std::swap(drawing, published);
+          hasSnapshot = false;
+        }
+      }
+      xe::Model::setFrameEpoch(drawing.epoch);
+      if(!engine.beginFrame()) return false;
+      float alpha = std::min(duration<float>(steady_clock::now() - drawing.tickTime).count() / tickTime, 1.f);
+      world.render(engine.getCamera(), drawing, PlayerController::interpolate(drawing.previousView, drawing.view, alpha));
       engine.endFrame();
+      return true;
+    });
+
+    while (engine.poll() && !replayFinished) {
+
+      accumulator += engine.getFrameTime();
+
+      int ticks = 0;
+      while(accumulator >= tickTime && ticks < MAX_CATCH_UP_TICKS) {
+        auto tickStart = steady_clock::now();
+        {
+          xe::FrameStats::Scope scope{xe::FrameStats::UPDATE};
+          if(replay != nullptr) {
+            playerController.previous = viewer.transform;
+            if(!replay->sample(tick, viewer.transform)) {
+              replayFinished = true;
+              break;
+            }
+          } else {
+            playerController.update(tickTime);
+          }
+        }
+        {
+          xe::FrameStats::Scope scope{xe::FrameStats::CHUNKS};
+          world.reloadChunks();
+          publish();
+        }
+        if(recording) {
+          recorded.record(viewer.transform);
+        }
+        if(replay != nullptr) {
+          auto counters = Chunk::takeCounters();
+          metrics.push_back({
+            counters.generated,
+            counters.meshed,
+            ChunkModels::takeUploadCount(),
+            drawn,
+            duration<float, std::milli>(steady_clock::now() - tickStart).count(),
+            xe::FrameStats::latest().frameTime});
+        }
+        accumulator -= tickTime;
+        ticks++;
+        tick++;
+      }
+      if(ticks == MAX_CATCH_UP_TICKS) {
+        accumulator = std::min(accumulator, tickTime);
+      }
+
+      if(engine.getInput().wasKeyPressed(KEY_F4)) {
+        if(xe::Trace::isEnabled()) {
+          xe::Trace::setEnabled(false);
+          xe::Trace::writeJson(TRACE_PATH);
+          std::cout << "Trace written to " << TRACE_PATH << std::endl;
+        } else {
+          xe::Trace::setEnabled(true);
+          std::cout << "Tracing started" << std::endl;
+        }
+      }
+
+      if(engine.getInput().wasKeyPressed(KEY_F3)) {
+        xe::FrameStats::writeCsv(FRAME_STATS_PATH);
+        std::cout << "Frame time p50 " << xe::FrameStats::percentile(50.f)
+                  << " ms, p95 " << xe::FrameStats::percentile(95.f)
+                  << " ms, p99 " << xe::FrameStats::percentile(99.f)
+                  << " ms, written to " << FRAME_STATS_PATH << std::endl;
+        printGpuResults();
+      }
+
+      if(replay == nullptr && engine.getInput().wasKeyPressed(KEY_F5)) {
+        if(recording) {
+          recorded.save(RECORDED_PATH);
+          std::cout << "Camera path of " << recorded.size() << " ticks written to " << RECORDED_PATH << std::endl;
+        } else {
+          recorded.clear();
+          std::cout << "Recording camera path" << std::endl;
+        }
+        recording = !recording;
+      }
+
+      std::this_thread::sleep_for(duration<float>(tickTime - accumulator));
+
     }
 
-  }
+    engine.stopRenderThread();
+    engine.close();
+
+    if(replay != nullptr) {
+      writeReplayMetrics(REPLAY_METRICS_PATH, metrics);
+      std::cout << "Replayed " << metrics.size() << " ticks, frame time p50 " << xe::FrameStats::percentile(50.f)
+                << " ms, p95 " << xe::FrameStats::percentile(95.f)
+                << " ms, p99 " << xe::FrameStats::percentile(99.f)
+                << " ms, written to " << REPLAY_METRICS_PATH << std::endl;
+      xe::FrameStats::keepAll(false);
+    }
+  });
+}
 
-  engine.close();
+// Draws a fixed number of frames without a window or a render thread, flying
+// the same curve at a fixed timestep on every run, so frame timings can be
+// compared between builds on machines without a display. Every
+// captureInterval frames the image is also written out, zero disables that.
+// Chunks still generate in the background, so captures of the same frame may
+// differ in how much of the world has loaded.
+void Minecraft::runOffscreen(int frames, int captureInterval) {
+  withWorld([&](xe::GameObject& viewer, World& world) {
+    const CameraPath path = defaultPath(OFFSCREEN_TIMESTEP, frames);
+    FrameSnapshot snapshot{};
+    xe::FrameStats::keepAll(true);
 
-  Chunk::unload();
+    for(int frame = 0; frame < frames; frame++) {
+      snapshot.previousView = viewer.transform;
+      path.sample(frame, viewer.transform);
+
+      {
+        xe::FrameStats::Scope scope{xe::FrameStats::CHUNKS};
+        world.reloadChunks();
+        snapshot.view = viewer.transform;
+        world.snapshot(snapshot);
+        snapshot.epoch = xe::Model::advanceEpoch();
+      }
+
+      xe::Model::setFrameEpoch(snapshot.epoch);
+      if(!engine.beginFrame()) continue;
+      world.render(engine.getCamera(), snapshot, snapshot.view);
+      engine.endFrame();
+
+      if(captureInterval > 0 && frame % captureInterval == 0) {
+        engine.captureFrame(CAPTURE_PATH + std::to_string(frame) + ".png");
+      }
+    }
 
+    engine.close();
+
+    xe::FrameStats::writeCsv(FRAME_STATS_PATH);
+    std::cout << "Offscreen frames " << frames
+              << ", frame time p50 " << xe::FrameStats::percentile(50.f)
+              << " ms, p95 " << xe::FrameStats::percentile(95.f)
+              << " ms, p99 " << xe::FrameStats::percentile(99.f)
+              << " ms, written to " << FRAME_STATS_PATH << std::endl;
+    printGpuResults();
+    xe::FrameStats::keepAll(false);
+  });
+}
+
+// Shader invocations are printed next to the pass time, a frame whose time
+// follows the fragment count is fill bound rather than vertex bound.
+void Minecraft::printGpuResults() {
+  for(const auto &[name, milliseconds] : engine.getGpuProfiler().getResults()) {
+    std::cout << "GPU " << name << " " << milliseconds << " ms" << std::endl;
+  }
+  if(engine.getGpuProfiler().getStatisticFlags() != 0) {
+    auto statistics = engine.getGpuProfiler().getStatistics();
+    std::cout << "GPU vertex invocations " << statistics.vertexInvocations
+              << ", fragment invocations " << statistics.fragmentInvocations << std::endl;
+  }
+}
+
+// A slow level turn starting where the player spawns, the same on every run.
+CameraPath Minecraft::defaultPath(float timestep, int steps) {
+  return CameraPath::curve({0.f, 40.f, 0.f}, glm::radians(45.f), PATH_SPEED, PATH_TURN_RATE, timestep, steps);
+}
+
+void Minecraft::writeReplayMetrics(const std::string& path, const std::vector<TickMetrics>& ticks) {
+  std::ofstream file{path};
+  if(!file.is_open()) {
+    throw std::runtime_error("failed to open replay metrics file: " + path);
+  }
+  file << "tick,generated,meshed,uploaded,drawn,tick_ms,frame_ms\n";
+  for(size_t i = 0; i < ticks.size(); i++) {
+    const TickMetrics& t = ticks[i];
+    file << i << "," << t.generated << "," << t.meshed << "," << t.uploaded << ","
+         << t.drawn << "," << t.tickTime << "," << t.frameTime << "\n";
+  }
 }
 
 }
\ No newline at end of file
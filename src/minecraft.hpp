@@ -5,12 +5,14 @@
 #include "player_controller.hpp"
 #include "chunk.hpp"
 #include "world.hpp"
+#include "camera_path.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 #include <array>
+#include <functional>
 #include <string>
 #include <memory>
 #include <vector>
@@ -20,16 +22,55 @@ namespace app {
 class Minecraft {
   public:
 
-    Minecraft();
+    static constexpr int OFFSCREEN_FRAMES = 600;
+    static constexpr int TICK_RATE = 30;
+    static constexpr int REPLAY_TICKS = TICK_RATE * 60;
+
+    // Defaults for the swap chain settings main can override per run.
+    static constexpr int FRAMES_IN_FLIGHT = 2;
+    static constexpr VkPresentModeKHR PRESENT_MODE = VK_PRESENT_MODE_MAILBOX_KHR;
+
+    Minecraft(xe::SwapChain::Config config);
     ~Minecraft();
 
-    void run();
+    void run(const CameraPath* replay = nullptr);
+    void runOffscreen(int frames, int captureInterval);
+
+    static CameraPath defaultPath(float timestep, int steps);
 
   private:
   
     static constexpr int WIDTH = 800;
     static constexpr int HEIGHT = 600;
 
+    static constexpr int MAX_CATCH_UP_TICKS = 5;
+
+    static constexpr int WORLD_SEED = 12345;
+
+    static constexpr const char* FRAME_STATS_PATH = "frame_stats.csv";
+    static constexpr const char* TRACE_PATH = "trace.json";
+    static constexpr const char* CAPTURE_PATH = "capture_";
+    static constexpr const char* RECORDED_PATH = "camera_path.txt";
+    static constexpr const char* REPLAY_METRICS_PATH = "replay_metrics.csv";
+
+    static constexpr float OFFSCREEN_TIMESTEP = 1.f / 60.f;
+    static constexpr float PATH_SPEED = 20.f;
+    static constexpr float PATH_TURN_RATE = 0.2f;
+
+    // What one simulation tick of a replay did, with the newest render frame.
+    struct TickMetrics {
+      uint32_t generated;
+      uint32_t meshed;
+      uint32_t uploaded;
+      size_t drawn;
+      float tickTime;
+      float frameTime;
+    };
+
+    void withWorld(const std::function<void(xe::GameObject& viewer, World& world)>& body);
+    void printGpuResults();
+    static void writeReplayMetrics(const std::string& path, const std::vector<TickMetrics>& ticks);
+
     xe::Engine engine;
 };
 }
\ No newline at end of file
@@ -2,12 +2,17 @@
 
 namespace app {
 
+static constexpr float MAX_TIMESTEP = 0.05f;
+static constexpr float SKIN = 0.001f;
+
 PlayerController::PlayerController(xe::Input &input, xe::GameObject &viewerObject)
-  : input{input}, viewerObject{viewerObject} {};
+  : input{input}, viewerObject{viewerObject}, previous{viewerObject.transform} {};
 
 PlayerController::~PlayerController() {};
 
 void PlayerController::update(float dt) {
+  previous = viewerObject.transform;
+
   glm::vec3 rotate{0};
   if(input.isKeyPressed(keys.lookRight)) rotate.y += 1.f;
   if(input.isKeyPressed(keys.lookLeft)) rotate.y -= 1.f;
@@ -26,18 +31,182 @@ void PlayerController::update(float dt) {
   const glm::vec3 rightDir{forwardDir.z, 0.f, -forwardDir.x};
   const glm::vec3 upDir{0.f, 1.f, 0.f};
 
+  if(input.wasKeyPressed(keys.toggleFlying)) {
+    flying = !flying;
+    velocity = glm::vec3(0.f);
+  }
+
   glm::vec3 moveDir{0};
   if(input.isKeyPressed(keys.moveForward)) moveDir += forwardDir;
   if(input.isKeyPressed(keys.moveBackward)) moveDir -= forwardDir;
   if(input.isKeyPressed(keys.moveRight)) moveDir += rightDir;
   if(input.isKeyPressed(keys.moveLeft)) moveDir -= rightDir;
-  if(input.isKeyPressed(keys.moveUp)) moveDir += upDir;
-  if(input.isKeyPressed(keys.moveDown)) moveDir -= upDir;
 
+  if(flying) {
+    if(input.isKeyPressed(keys.moveUp)) moveDir += upDir;
+    if(input.isKeyPressed(keys.moveDown)) moveDir -= upDir;
+    if (glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon()) {
+      viewerObject.transform.translation += moveSpeed * dt * glm::normalize(moveDir);
+    }
+    return;
+  }
+
+  glm::vec3 walk{0};
   if (glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon()) {
-    viewerObject.transform.translation += moveSpeed * dt * glm::normalize(moveDir);
+    walk = walkSpeed * glm::normalize(moveDir);
   }
+  velocity.x = walk.x;
+  velocity.z = walk.z;
+  if(grounded && input.isKeyPressed(keys.moveUp)) velocity.y = jumpSpeed;
+  // Long frames are clamped so a hitch can't carry the player through a
+  // floor or blow the neighbourhood cache up to hundreds of blocks.
+  dt = std::min(dt, MAX_TIMESTEP);
+  velocity.y = std::max(velocity.y - gravity * dt, -terminalSpeed);
+
+  move(velocity * dt);
+
+}
+
+// The view alpha of the way between two updates. Yaw wraps at two pi, so it
+// is blended the short way around.
+xe::TransformComponent PlayerController::interpolate(const xe::TransformComponent& from, const xe::TransformComponent& to, float alpha) {
+  xe::TransformComponent transform = to;
+  transform.translation = glm::mix(from.translation, to.translation, alpha);
+  transform.rotation.x = glm::mix(from.rotation.x, to.rotation.x, alpha);
+  float yaw = to.rotation.y - from.rotation.y;
+  if(yaw > glm::pi<float>()) yaw -= glm::two_pi<float>();
+  if(yaw < -glm::pi<float>()) yaw += glm::two_pi<float>();
+  transform.rotation.y = from.rotation.y + yaw * alpha;
+  return transform;
+}
+
+//
+//  PLAYER COLLISION
+//
+
+// Moves the player box one axis at a time, vertical first so ground contact is
+// known before walking. A blocked walk while on the ground is retried raised by
+// STEP_HEIGHT and kept if it gets further, which climbs single block ledges.
+void PlayerController::move(glm::vec3 delta) {
+  const glm::vec3 half{PLAYER_WIDTH / 2.f, 0.f, PLAYER_WIDTH / 2.f};
+  glm::vec3 feet = viewerObject.transform.translation - glm::vec3(0.f, EYE_HEIGHT, 0.f);
+  glm::vec3 min = feet - half;
+  glm::vec3 max = feet + half + glm::vec3(0.f, PLAYER_HEIGHT, 0.f);
+
+  glm::vec3 reach{0.f, STEP_HEIGHT, 0.f};
+  cacheNeighbourhood(min + glm::min(delta, glm::vec3(0.f)) - reach, max + glm::max(delta, glm::vec3(0.f)) + reach);
+
+  float moved = sweep(min, max, 1, delta.y);
+  grounded = delta.y < 0.f && moved > delta.y;
+  if(moved != delta.y) velocity.y = 0.f;
+
+  glm::vec3 stepMin = min;
+  glm::vec3 stepMax = max;
+
+  float movedX = sweep(min, max, 0, delta.x);
+  float movedZ = sweep(min, max, 2, delta.z);
+
+  if(grounded && (movedX != delta.x || movedZ != delta.z)) {
+    float raised = sweep(stepMin, stepMax, 1, STEP_HEIGHT);
+    float stepX = sweep(stepMin, stepMax, 0, delta.x);
+    float stepZ = sweep(stepMin, stepMax, 2, delta.z);
+    sweep(stepMin, stepMax, 1, -raised);
+    if(stepX * stepX + stepZ * stepZ > movedX * movedX + movedZ * movedZ) {
+      min = stepMin;
+      max = stepMax;
+    }
+  }
+
+  viewerObject.transform.translation = glm::vec3(min.x + half.x, min.y + EYE_HEIGHT, min.z + half.z);
+}
+
+// Moves the box along one axis by up to delta and returns how far it got. Only
+// the layers of voxels the leading face passes into are tested, so a box that
+// ends up slightly inside a block can still move out of it.
+float PlayerController::sweep(glm::vec3& min, glm::vec3& max, int axis, float delta) {
+  if(delta == 0.f) return 0.f;
+  const int axis1 = (axis + 1) % 3;
+  const int axis2 = (axis + 2) % 3;
+  const int min1 = static_cast<int>(floor(min[axis1]));
+  const int max1 = static_cast<int>(ceil(max[axis1])) - 1;
+  const int min2 = static_cast<int>(floor(min[axis2]));
+  const int max2 = static_cast<int>(ceil(max[axis2])) - 1;
+
+  auto blocked = [&](int layer) {
+    glm::ivec3 voxel{0};
+    voxel[axis] = layer;
+    for(voxel[axis2] = min2; voxel[axis2] <= max2; voxel[axis2]++) {
+      for(voxel[axis1] = min1; voxel[axis1] <= max1; voxel[axis1]++) {
+        if(isSolid(voxel.x, voxel.y, voxel.z)) return true;
+      }
+    }
+    return false;
+  };
+
+  float moved = delta;
+  if(delta > 0.f) {
+    int last = static_cast<int>(ceil(max[axis] + delta)) - 1;
+    for(int layer = static_cast<int>(ceil(max[axis])); layer <= last; layer++) {
+      if(!blocked(layer)) continue;
+      moved = std::clamp(layer - max[axis] - SKIN, 0.f, delta);
+      break;
+    }
+  } else {
+    int last = static_cast<int>(floor(min[axis] + delta));
+    for(int layer = static_cast<int>(floor(min[axis])) - 1; layer >= last; layer--) {
+      if(!blocked(layer)) continue;
+      moved = std::clamp(layer + 1 - min[axis] + SKIN, delta, 0.f);
+      break;
+    }
+  }
+
+  min[axis] += moved;
+  max[axis] += moved;
+  return moved;
+}
+
+// Copies every block the player could touch this update out of the chunks up
+// front, looking each chunk up once, so the sweeps above are plain array reads.
+// Columns in chunks that are missing or still generating read as solid, which
+// holds the player in place until the terrain under them exists.
+void PlayerController::cacheNeighbourhood(glm::vec3 min, glm::vec3 max) {
+  cacheMin = glm::ivec3(glm::floor(min)) - 1;
+  cacheSize = glm::ivec3(glm::floor(max)) + 2 - cacheMin;
+  cache.assign(cacheSize.x * cacheSize.y * cacheSize.z, static_cast<uint8_t>(INVALID));
+
+  Chunk* chunk = nullptr;
+  bool looked = false;
+  int chunkX = 0, chunkZ = 0;
+  for(int z = 0; z < cacheSize.z; z++) {
+    for(int x = 0; x < cacheSize.x; x++) {
+      int worldX = cacheMin.x + x;
+      int worldZ = cacheMin.z + z;
+      int gridX = ChunkTerrain::floorDiv(worldX, Chunk::CHUNK_SIZE.x);
+      int gridZ = ChunkTerrain::floorDiv(worldZ, Chunk::CHUNK_SIZE.z);
+      if(!looked || gridX != chunkX || gridZ != chunkZ) {
+        chunk = Chunk::getChunk(gridX, gridZ);
+        looked = true;
+        chunkX = gridX;
+        chunkZ = gridZ;
+      }
+      if(chunk == nullptr || !chunk->isGenerated()) continue;
+      for(int y = 0; y < cacheSize.y; y++) {
+        int worldY = cacheMin.y + y;
+        if(worldY < 0) continue;
+        uint8_t block = worldY >= Chunk::CHUNK_SIZE.y ? AIR : chunk->getBlock(worldX - gridX * Chunk::CHUNK_SIZE.x, worldY, worldZ - gridZ * Chunk::CHUNK_SIZE.z);
+        cache[x + (y * cacheSize.x) + (z * cacheSize.x * cacheSize.y)] = block;
+      }
+    }
+  }
+}
 
+bool PlayerController::isSolid(int x, int y, int z) {
+  x -= cacheMin.x;
+  y -= cacheMin.y;
+  z -= cacheMin.z;
+  if(x < 0 || y < 0 || z < 0 || x >= cacheSize.x || y >= cacheSize.y || z >= cacheSize.z) return true;
+  uint8_t block = cache[x + (y * cacheSize.x) + (z * cacheSize.x * cacheSize.y)];
+  return block != AIR && block != WATER;
 }
 
 }
\ No newline at end of file
@@ -3,11 +3,14 @@
 #include "xe_game_object.hpp"
 #include "xe_input.hpp"
 
+#include "chunk.hpp"
+
 #define GLM_FORCE_RADIANS
 #include <glm/common.hpp>
 #include <glm/fwd.hpp>
 #include <glm/geometric.hpp>
 #include <limits>
+#include <vector>
 
 namespace app {
 
@@ -29,9 +32,16 @@ namespace app {
         int lookRight = KEY_RIGHT;
         int lookUp = KEY_UP;
         int lookDown = KEY_DOWN;
+        int toggleFlying = KEY_F;
       };
 
+      static constexpr float PLAYER_WIDTH = 0.6f;
+      static constexpr float PLAYER_HEIGHT = 1.8f;
+      static constexpr float EYE_HEIGHT = 1.62f;
+      static constexpr float STEP_HEIGHT = 1.f;
+
       void update(float dt);
+      static xe::TransformComponent interpolate(const xe::TransformComponent& from, const xe::TransformComponent& to, float alpha);
 
       xe::Input &input;
       xe::GameObject &viewerObject;
@@ -39,6 +49,27 @@ namespace app {
       KeyMappings keys{};
       float moveSpeed{100.f};
       float lookSpeed{1.5f};
+      float walkSpeed{4.3f};
+      float jumpSpeed{8.f};
+      float gravity{28.f};
+      float terminalSpeed{60.f};
+
+      bool flying{false};
+      bool grounded{false};
+      glm::vec3 velocity{0.f};
+      xe::TransformComponent previous{};
+
+    private:
+
+      void move(glm::vec3 delta);
+      float sweep(glm::vec3& min, glm::vec3& max, int axis, float delta);
+
+      void cacheNeighbourhood(glm::vec3 min, glm::vec3 max);
+      bool isSolid(int x, int y, int z);
+
+      glm::ivec3 cacheMin{0};
+      glm::ivec3 cacheSize{0};
+      std::vector<uint8_t> cache{};
 
   };
 }
\ No newline at end of file
@@ -3,7 +3,7 @@
 
 namespace app {
 
-SkinnedRenderer::SkinnedRenderer(std::vector<xe::Image*> &images) {
+SkinnedRenderer::SkinnedRenderer(xe::Image* texture) {
   xeRenderSystem = xe::RenderSystem::Builder("res/shaders/simple_shader.vert.spv", "res/shaders/simple_shader.frag.spv")
     .addVertexBindingf(0, 3, 0) // position
     .addVertexBindingf(1, 3, 12) // normal
@@ -12,31 +12,62 @@ SkinnedRenderer::SkinnedRenderer(std::vector<xe::Image*> &images) {
     .setVertexSize(36)
     .addPushConstant(sizeof(PushConstant))
     .addUniformBinding(0, sizeof(UniformBuffer))
-    .addTextureArrayBinding(1, images)
+    .addTextureBinding(1, texture)
     .setCulling(true)
     .setWireframe(false)
     .build();
 }
 
-void SkinnedRenderer::render(std::vector<xe::GameObject> &gameObjects, xe::Camera &xeCamera) {
+// Small frames are recorded inline, since waking the recording threads costs
+// more than it saves. Past the threshold the draws are split across them.
+void SkinnedRenderer::render(const std::vector<DrawCall> &draws, xe::Camera &xeCamera) {
+  if(draws.size() < PARALLEL_DRAW_THRESHOLD) {
+    begin(xeCamera);
+    for(const auto &draw : draws) {
+      this->draw(draw.model, draw.modelMatrix, draw.normalMatrix);
+    }
+    end();
+    return;
+  }
 
+  xeRenderSystem->startParallel();
+  loadUniforms(xeCamera);
+  xeRenderSystem->renderParallel(draws.size(), [&](VkCommandBuffer commandBuffer, size_t i) {
+    const DrawCall &draw = draws[i];
+    if(draw.model == nullptr) return;
+    PushConstant pc{};
+    pc.modelMatrix = draw.modelMatrix;
+    pc.normalMatrix = draw.normalMatrix;
+    xeRenderSystem->loadPushConstant(commandBuffer, &pc);
+    xeRenderSystem->render(commandBuffer, draw.model);
+  });
+  end();
+}
+
+void SkinnedRenderer::begin(xe::Camera &xeCamera) {
   xeRenderSystem->start();
+  loadUniforms(xeCamera);
+}
 
+void SkinnedRenderer::loadUniforms(xe::Camera &xeCamera) {
   UniformBuffer ubo{};
   ubo.projectionView = xeCamera.getProjection() * xeCamera.getView();
+  ubo.cameraPosition = xeCamera.getPosition();
+  ubo.fogDistance = fogDistance;
   xeRenderSystem->loadUniformObject(0, &ubo);
+}
 
-  for(auto &obj : gameObjects) {
-    if(obj.model == nullptr) continue;
-    PushConstant pc{};
-    pc.modelMatrix = obj.transform.mat4();
-    pc.normalMatrix = obj.transform.normalMatrix();
-    xeRenderSystem->loadPushConstant(&pc);
-    xeRenderSystem->render(obj);
-  }
+void SkinnedRenderer::draw(xe::Model *model, const glm::mat4 &modelMatrix, const glm::mat4 &normalMatrix) {
+  if(model == nullptr) return;
+  PushConstant pc{};
+  pc.modelMatrix = modelMatrix;
+  pc.normalMatrix = normalMatrix;
+  xeRenderSystem->loadPushConstant(&pc);
+  xeRenderSystem->render(model);
+}
 
+void SkinnedRenderer::end() {
   xeRenderSystem->stop();
-
 }
 
 }
\ No newline at end of file
@@ -9,6 +9,8 @@ namespace app {
 struct UniformBuffer {
   alignas(16) glm::mat4 projectionView{1.f};
   alignas(4) glm::vec3 lightDirection = glm::normalize(glm::vec3{-1.f, 3.f, 1.f});
+  alignas(16) glm::vec3 cameraPosition{0.f};
+  alignas(4) float fogDistance{0.f};
 };
 
 struct PushConstant {
@@ -16,20 +18,37 @@ struct PushConstant {
   alignas(16) glm::mat4 normalMatrix{1.f};
 };
 
+struct DrawCall {
+  xe::Model* model;
+  glm::mat4 modelMatrix;
+  glm::mat4 normalMatrix;
+};
+
 class SkinnedRenderer {
 
   public:
 
-    SkinnedRenderer(std::vector<xe::Image*> &images);
+    static constexpr size_t PARALLEL_DRAW_THRESHOLD = 128;
+
+    SkinnedRenderer(xe::Image* texture);
 
     ~SkinnedRenderer() {};
 
     SkinnedRenderer(const SkinnedRenderer&) = delete;
     SkinnedRenderer operator=(const SkinnedRenderer&) = delete;
 
-    void render(std::vector<xe::GameObject> &gameObjects, xe::Camera &xeCamera);
+    void render(const std::vector<DrawCall> &draws, xe::Camera &xeCamera);
+
+    void begin(xe::Camera &xeCamera);
+    void draw(xe::Model *model, const glm::mat4 &modelMatrix, const glm::mat4 &normalMatrix);
+    void end();
+
+    void setFogDistance(float distance) { fogDistance = distance; }
 
   private:
+    void loadUniforms(xe::Camera &xeCamera);
+
+    float fogDistance{0.f};
     std::unique_ptr<xe::RenderSystem> xeRenderSystem;
 
 };
@@ -1,117 +1,264 @@
 #include "world.hpp"
 
+#include <cmath>
+#include <stdexcept>
+
 namespace app {
 
 World::World(xe::GameObject& viewer, int renderDistance, int worldSeed) 
   : viewer{viewer}, 
     renderDistance{renderDistance},
     worldSeed{worldSeed},
-    skinnedRenderer{Chunk::getTextures()} {
+    farTerrain{static_cast<uint32_t>(worldSeed)},
+    skinnedRenderer{ChunkModels::getTexture()} {
+  Region::open("saves/" + std::to_string(worldSeed));
   reloadChunks(renderDistance);
 }
 
-World::~World() {}
+World::~World() {
+  unloadAllChunks();
+  ChunkCache::clear();
+  Region::close();
+}
 
 void World::reloadChunks() {
   int currentViewX = static_cast<int>(floor(viewer.transform.translation.x / Chunk::CHUNK_SIZE.x));
   int currentViewZ = static_cast<int>(floor(viewer.transform.translation.z / Chunk::CHUNK_SIZE.z));
   if(currentViewX != viewX || currentViewZ != viewZ) {
+    int oldViewX = viewX;
+    int oldViewZ = viewZ;
     viewX = currentViewX;
     viewZ = currentViewZ;
-    unloadOldChunks();
-    loadNewChunks();
+    unloadOldChunks(oldViewX, oldViewZ);
+    loadNewChunks(oldViewX, oldViewZ, renderDistance);
   }
   updateChunkMeshs();
+  farTerrain.update(viewer.transform.translation, renderDistance * Chunk::CHUNK_SIZE.x);
 }
 
 void World::reloadChunks(int newRenderDistance) {
+  unloadAllChunks();
   renderDistance = newRenderDistance;
   viewX = static_cast<int>(floor(viewer.transform.translation.x / Chunk::CHUNK_SIZE.x));
   viewZ = static_cast<int>(floor(viewer.transform.translation.z / Chunk::CHUNK_SIZE.z));
   resetChunks();
-  loadNewChunks();
+  loadNewChunks(viewX, viewZ, -1);
   updateChunkMeshs();
+  farTerrain.update(viewer.transform.translation, renderDistance * Chunk::CHUNK_SIZE.x);
+  setFog(fog);
+}
+
+void World::setLodDistance(int distance) {
+  lodDistance = distance;
+}
+
+void World::setFog(bool enabled) {
+  fog = enabled;
+  fogDistance = fog ? FarTerrain::RADIUS : 0.f;
 }
 
 void World::resetChunks() {
-  unloadOldChunks();
+  width = 2*renderDistance+1;
   loadedChunks.clear();
-  int width = 2*renderDistance+1;
+  slots.clear();
   for(int i = 0; i < width*width; i++) {
     auto gameObject = xe::GameObject::createGameObject();
     loadedChunks.push_back(std::move(gameObject));
+    slots.push_back(nullptr);
   }
 }
 
-void World::unloadOldChunks() {
-  int minX = viewX - renderDistance;
-  int minZ = viewZ - renderDistance;
-  int maxX = viewX + renderDistance;
-  int maxZ = viewZ + renderDistance;
-  for(auto &object : loadedChunks) {
-    int gridX = static_cast<int>(floor(object.transform.translation.x / Chunk::CHUNK_SIZE.x));
-    int gridZ = static_cast<int>(floor(object.transform.translation.z / Chunk::CHUNK_SIZE.z));
-    if(gridX < minX || gridZ < minZ || gridX > maxX || gridZ > maxZ){
-        Chunk::deleteChunk(gridX, gridZ);
-        object.model = nullptr;
+//
+//  SLIDING WINDOW CHUNK LOADING
+//
+
+// The window is the circle of radius renderDistance around the view chunk,
+// stored in a toroidal grid: a chunk always occupies the slot at its grid
+// coordinate modulo the window width, so a chunk entering the window takes
+// the slot of the one leaving on the opposite side and nothing else moves.
+int World::slotIndex(int gridX, int gridZ) {
+  int x = ((gridX % width) + width) % width;
+  int z = ((gridZ % width) + width) % width;
+  return x + z * width;
+}
+
+// Half width of the row offsetZ chunks from the view in a circle of the given
+// radius. The extra distance term rounds the circle the way (r + 0.5)^2 would,
+// so the rows at the very edge aren't single chunks.
+int World::rowSpan(int offsetZ, int distance) {
+  if(distance < 0 || abs(offsetZ) > distance) return -1;
+  return static_cast<int>(floor(sqrt(distance * distance + distance - offsetZ * offsetZ)));
+}
+
+// Visits every chunk in the window of the given distance around from that is
+// not in the window around to, one row at a time, so the work is proportional
+// to the rows and chunks that actually change.
+void World::forEachExclusive(int fromX, int fromZ, int fromDistance, int toX, int toZ, int toDistance, const std::function<void(int, int)>& fn) {
+  for(int z = fromZ - fromDistance; z <= fromZ + fromDistance; z++) {
+    int fromSpan = rowSpan(z - fromZ, fromDistance);
+    int toSpan = rowSpan(z - toZ, toDistance);
+    int minX = fromX - fromSpan;
+    int maxX = fromX + fromSpan;
+    if(toSpan < 0) {
+      for(int x = minX; x <= maxX; x++) fn(x, z);
+      continue;
     }
+    for(int x = minX; x <= std::min(maxX, toX - toSpan - 1); x++) fn(x, z);
+    for(int x = std::max(minX, toX + toSpan + 1); x <= maxX; x++) fn(x, z);
   }
 }
 
-void World::loadNewChunks() {
-  int width = 2*renderDistance+1;
-  int minX = viewX - renderDistance;
-  int minZ = viewZ - renderDistance;
-  int maxX = viewX + renderDistance;
-  int maxZ = viewZ + renderDistance;
-  int i = 0;
-  for(auto &object : loadedChunks) {
-    int gridX = minX + i % width;
-    int gridZ = minZ + i / width;
-    Chunk* chunk = Chunk::getChunk(gridX, gridZ);
-    if(chunk == nullptr) {
-      chunk = Chunk::newChunk(gridX, gridZ, worldSeed);
-      Chunk::generateAsync(chunk);
-    }
-    object.transform.translation = glm::vec3(gridX * Chunk::CHUNK_SIZE.x, 0, gridZ * Chunk::CHUNK_SIZE.z);
-    i++;
+void World::unloadOldChunks(int oldViewX, int oldViewZ) {
+  forEachExclusive(oldViewX, oldViewZ, renderDistance, viewX, viewZ, renderDistance, [this](int gridX, int gridZ) {
+    unloadChunk(gridX, gridZ);
+  });
+}
+
+void World::loadNewChunks(int oldViewX, int oldViewZ, int oldRenderDistance) {
+  forEachExclusive(viewX, viewZ, renderDistance, oldViewX, oldViewZ, oldRenderDistance, [this](int gridX, int gridZ) {
+    loadChunk(gridX, gridZ);
+  });
+}
+
+void World::unloadAllChunks() {
+  for(int i = 0; i < slots.size(); i++) {
+    if(slots[i] == nullptr) continue;
+    unloadChunk(slots[i]->gridX, slots[i]->gridZ);
+  }
+}
+
+void World::loadChunk(int gridX, int gridZ) {
+  Chunk* chunk = Chunk::getChunk(gridX, gridZ);
+  if(chunk == nullptr) {
+    chunk = Chunk::newChunk(gridX, gridZ, worldSeed);
+    Chunk::generateAsync(chunk);
   }
+  int slot = slotIndex(gridX, gridZ);
+  slots[slot] = chunk;
+  loadedChunks[slot].model = nullptr;
+  loadedChunks[slot].transform.translation = glm::vec3(gridX * Chunk::CHUNK_SIZE.x, 0, gridZ * Chunk::CHUNK_SIZE.z);
+}
+
+void World::unloadChunk(int gridX, int gridZ) {
+  int slot = slotIndex(gridX, gridZ);
+  Chunk* chunk = slots[slot];
+  if(chunk == nullptr || chunk->gridX != gridX || chunk->gridZ != gridZ) return;
+  Chunk::deleteChunk(gridX, gridZ);
+  ChunkModels::remove(gridX, gridZ);
+  slots[slot] = nullptr;
+  loadedChunks[slot].model = nullptr;
+}
+
+// Every lodDistance chunks away from the view halves the mesh resolution, up
+// to Chunk::MAX_LOD. Chunks keep drawing their old mesh while a mesh at their
+// new level is built.
+int World::lodFor(int gridX, int gridZ) {
+  if(lodDistance <= 0) return 0;
+  int offsetX = gridX - viewX;
+  int offsetZ = gridZ - viewZ;
+  int distance = static_cast<int>(sqrt(offsetX * offsetX + offsetZ * offsetZ));
+  return std::min(distance / lodDistance, Chunk::MAX_LOD);
 }
 
 void World::updateChunkMeshs() {
-  for(auto &object : loadedChunks) {
-    int gridX = static_cast<int>(floor(object.transform.translation.x / Chunk::CHUNK_SIZE.x));
-    int gridZ = static_cast<int>(floor(object.transform.translation.z / Chunk::CHUNK_SIZE.z));
-    Chunk* chunk = Chunk::getChunk(gridX, gridZ);
+  for(int i = 0; i < slots.size(); i++) {
+    Chunk* chunk = slots[i];
     if(chunk == nullptr) continue;
-    if(chunk->getMesh() == nullptr)
-      Chunk::createMeshAsync(chunk);
-    object.model = chunk->getMesh();
+    int lod = lodFor(chunk->gridX, chunk->gridZ);
+    xe::Model* model = ChunkModels::update(chunk);
+    if(model == nullptr || chunk->getLod() != lod)
+      Chunk::createMeshAsync(chunk, lod);
+    loadedChunks[i].model = model;
   }
 }
 
-void World::render(xe::Camera& camera) {
-  camera.setViewYXZ(viewer.transform.translation, viewer.transform.rotation);
-  // World::Ray ray = raycast(7, 100);
-  skinnedRenderer.render(loadedChunks, camera);
+void World::snapshot(FrameSnapshot& snapshot) {
+  snapshot.fogDistance = fogDistance;
+  snapshot.draws.clear();
+  for(auto &chunk : loadedChunks) {
+    if(chunk.model == nullptr) continue;
+    snapshot.draws.push_back({chunk.model, chunk.transform.mat4(), chunk.transform.normalMatrix()});
+  }
+  xe::GameObject& horizon = farTerrain.getObject();
+  if(horizon.model != nullptr) {
+    snapshot.draws.push_back({horizon.model, horizon.transform.mat4(), horizon.transform.normalMatrix()});
+  }
 }
 
-World::Ray World::raycast(float distance, int steps) {
-
-  glm::vec3 position = glm::vec3(viewer.transform.translation);
+// Called from the render thread, so it may only read the snapshot and never
+// the chunks themselves.
+void World::render(xe::Camera& camera, const FrameSnapshot& snapshot, const xe::TransformComponent& view) {
+  camera.setViewYXZ(view.translation, view.rotation);
+  // World::Ray ray = raycast(7);
+  skinnedRenderer.setFogDistance(snapshot.fogDistance);
+  skinnedRenderer.render(snapshot.draws, camera);
+}
 
+World::Ray World::raycast(float distance) {
   float pitch = viewer.transform.rotation.x;
   float yaw = viewer.transform.rotation.y;
   float clamp = 1-fabs(sin(-pitch));
-  const glm::vec3 step = glm::normalize(glm::vec3(sin(yaw)*clamp, sin(-pitch), cos(yaw)*clamp)) * (distance/steps);
+  const glm::vec3 direction = glm::vec3(sin(yaw)*clamp, sin(-pitch), cos(yaw)*clamp);
+  return raycast(viewer.transform.translation, direction, distance);
+}
+
+// Amanatides-Woo traversal: steps from voxel boundary to voxel boundary along
+// the ray, so every voxel it passes through is visited exactly once. The chunk
+// is only looked up again when the ray crosses into a different one.
+World::Ray World::raycast(glm::vec3 origin, glm::vec3 direction, float distance) {
+  glm::ivec3 voxel = glm::ivec3(glm::floor(origin));
+  if(glm::length(direction) == 0.f) return World::Ray{voxel, glm::ivec3(0), INVALID};
+  direction = glm::normalize(direction);
 
-  for(int i = 0; i < steps; i++) {
-    position += step;
-    int hit = Chunk::getGlobalBlock(position.x, position.y, position.z);
-    if(hit == AIR) continue;
-    return World::Ray{position, hit};
+  glm::ivec3 step{0};
+  glm::vec3 tDelta{INFINITY};
+  glm::vec3 tMax{INFINITY};
+  for(int axis = 0; axis < 3; axis++) {
+    if(direction[axis] == 0.f) continue;
+    step[axis] = direction[axis] > 0.f ? 1 : -1;
+    tDelta[axis] = fabs(1.f / direction[axis]);
+    float boundary = direction[axis] > 0.f ? voxel[axis] + 1 - origin[axis] : origin[axis] - voxel[axis];
+    tMax[axis] = boundary * tDelta[axis];
+  }
+
+  Chunk* chunk = nullptr;
+  int chunkX = 0, chunkZ = 0;
+  glm::ivec3 normal{0};
+  float t = 0.f;
+
+  while(t <= distance) {
+    if(voxel.y < 0) break;
+    if(voxel.y < Chunk::CHUNK_SIZE.y) {
+      int gridX = ChunkTerrain::floorDiv(voxel.x, Chunk::CHUNK_SIZE.x);
+      int gridZ = ChunkTerrain::floorDiv(voxel.z, Chunk::CHUNK_SIZE.z);
+      if(chunk == nullptr || gridX != chunkX || gridZ != chunkZ) {
+        chunk = Chunk::getChunk(gridX, gridZ);
+        chunkX = gridX;
+        chunkZ = gridZ;
+        if(chunk == nullptr || !chunk->isGenerated()) break;
+      }
+      int hit = chunk->getBlock(voxel.x - gridX * Chunk::CHUNK_SIZE.x, voxel.y, voxel.z - gridZ * Chunk::CHUNK_SIZE.z);
+      if(hit != AIR) return World::Ray{voxel, normal, hit};
+    }
+
+    int axis = tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+    t = tMax[axis];
+    tMax[axis] += tDelta[axis];
+    voxel[axis] += step[axis];
+    normal = glm::ivec3(0);
+    normal[axis] = -step[axis];
+  }
+  return World::Ray{voxel, glm::ivec3(0), INVALID};
+}
+
+void World::raycast(const std::vector<glm::vec3>& origins, const std::vector<glm::vec3>& directions, float distance, std::vector<Ray>& hits) {
+  if(origins.size() != directions.size()) {
+    throw std::runtime_error("ray origins and directions differ in count");
+  }
+  hits.resize(origins.size());
+  for(size_t i = 0; i < origins.size(); i++) {
+    hits[i] = raycast(origins[i], directions[i], distance);
   }
-  return World::Ray{position, INVALID};
 }
 
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "xe_game_object.hpp"
 #include "skinned_renderer.hpp"
 #include "chunk.hpp"
+#include "chunk_models.hpp"
+#include "far_terrain.hpp"
 
 #define GLM_FORCE_RADIANS
 #include <glm/common.hpp>
@@ -10,15 +12,29 @@
 #include <glm/geometric.hpp>
 
 #include <vector>
+#include <functional>
+#include <chrono>
 
 namespace app {
 
+// Everything the render thread needs to draw one simulation tick. It is built
+// on the simulation thread and never changed once handed over.
+struct FrameSnapshot {
+  xe::TransformComponent previousView{};
+  xe::TransformComponent view{};
+  std::chrono::steady_clock::time_point tickTime{};
+  float fogDistance{0.f};
+  uint64_t epoch{0};
+  std::vector<DrawCall> draws{};
+};
+
 class World {
 
   public:
 
     struct Ray {
       glm::ivec3 pos;
+      glm::ivec3 normal;
       int hit;
     };
 
@@ -27,26 +43,46 @@ class World {
 
     void reloadChunks();
     void reloadChunks(int newRenderDistance);
+    void setFog(bool enabled);
+    void setLodDistance(int distance);
     
-    void render(xe::Camera& camera);
+    void snapshot(FrameSnapshot& snapshot);
+    void render(xe::Camera& camera, const FrameSnapshot& snapshot, const xe::TransformComponent& view);
 
-    Ray raycast(float distance, int steps);
+    Ray raycast(float distance);
+    Ray raycast(glm::vec3 origin, glm::vec3 direction, float distance);
+    void raycast(const std::vector<glm::vec3>& origins, const std::vector<glm::vec3>& directions, float distance, std::vector<Ray>& hits);
 
   private:
 
     void resetChunks();
 
-    void unloadOldChunks();
-    void loadNewChunks();
+    int slotIndex(int gridX, int gridZ);
+    int rowSpan(int offsetZ, int distance);
+    void forEachExclusive(int fromX, int fromZ, int fromDistance, int toX, int toZ, int toDistance, const std::function<void(int, int)>& fn);
+
+    void unloadOldChunks(int oldViewX, int oldViewZ);
+    void loadNewChunks(int oldViewX, int oldViewZ, int oldRenderDistance);
+    void unloadAllChunks();
+    void loadChunk(int gridX, int gridZ);
+    void unloadChunk(int gridX, int gridZ);
+    int lodFor(int gridX, int gridZ);
     void updateChunkMeshs();
 
     int viewX, viewZ;
 
     int worldSeed;
     int renderDistance;
+    int width{0};
+    bool fog{true};
+    float fogDistance{0.f};
+    int lodDistance{8};
     
     const xe::GameObject& viewer;
     std::vector<xe::GameObject> loadedChunks;
+    std::vector<Chunk*> slots;
+
+    FarTerrain farTerrain;
 
     SkinnedRenderer skinnedRenderer;
 